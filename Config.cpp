@@ -21,6 +21,7 @@ void Config::Load(const std::wstring& configDir)
 
     m_config.wsPort = GetPrivateProfileIntW(L"Connection", L"Port", 25885, m_configPath.c_str());
     m_config.reconnectInterval = GetPrivateProfileIntW(L"Connection", L"ReconnectInterval", 5000, m_configPath.c_str());
+    m_config.maxMessageSizeKB = GetPrivateProfileIntW(L"Connection", L"MaxMessageSizeKB", 16384, m_configPath.c_str());
 
     m_config.displayWidth = GetPrivateProfileIntW(L"Display", L"Width", 300, m_configPath.c_str());
     m_config.fontSize = GetPrivateProfileIntW(L"Display", L"FontSize", 11, m_configPath.c_str());
@@ -70,6 +71,9 @@ void Config::Save()
     swprintf_s(buffer, L"%d", m_config.reconnectInterval);
     WritePrivateProfileStringW(L"Connection", L"ReconnectInterval", buffer, m_configPath.c_str());
 
+    swprintf_s(buffer, L"%d", m_config.maxMessageSizeKB);
+    WritePrivateProfileStringW(L"Connection", L"MaxMessageSizeKB", buffer, m_configPath.c_str());
+
     swprintf_s(buffer, L"%d", m_config.displayWidth);
     WritePrivateProfileStringW(L"Display", L"Width", buffer, m_configPath.c_str());
 
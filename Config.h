@@ -14,6 +14,7 @@ struct PluginConfig
     // Connection
     int wsPort = 25885;
     int reconnectInterval = 5000;
+    int maxMessageSizeKB = 16384;  // Largest WebSocket message accepted from SPlayer
 
     // Display
     int displayWidth = 300;
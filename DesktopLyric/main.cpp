@@ -11,6 +11,7 @@
 #include <d2d1_1.h>
 #include <dwrite.h>
 #include <shlwapi.h>
+#include <shellapi.h>
 #include <string>
 #include <vector>
 
@@ -29,13 +30,50 @@ ID2D1DCRenderTarget* g_pDCRenderTarget = nullptr;
 IDWriteFactory* g_pDWriteFactory = nullptr;
 IDWriteTextFormat* g_pTextFormat = nullptr;
 
+// Window surface kept across frames: the DIB that UpdateLayeredWindow reads,
+// its memory DC (bound to the render target once) and the brushes. Rebuilt
+// only on resize, DPI change or when Direct2D reports the target lost.
+struct RenderContext {
+    HDC memDC = nullptr;
+    HBITMAP dib = nullptr;
+    HGDIOBJ oldBitmap = nullptr;
+    int width = 0, height = 0;
+    bool bound = false;
+    ID2D1SolidColorBrush* pNormal = nullptr;
+    ID2D1SolidColorBrush* pHi = nullptr;
+    ID2D1SolidColorBrush* pInactive = nullptr;
+} g_render;
+
+// DirectWrite layout of one displayed line. Shaping, font fallback and line
+// layout run once when the line appears; later frames only draw it.
+struct TextLayoutSlot {
+    IDWriteTextLayout* layout = nullptr;
+    uint64_t lyricsVersion = 0;
+    int64_t lineIndex = -2;
+    float width = 0, height = 0;
+    std::vector<float> wordX;   // Left edge of each YRC word, then the right end of the last
+} g_layoutCurrent, g_layoutSecond;
+
 std::wstring g_lastLine;
 std::wstring g_currentLine;
 std::wstring g_secondLine;
 float g_scrollPos = 0.0f; 
 int64_t g_lastLyricIndex = -1;
+uint64_t g_lastLyricsVersion = 0;
 const int REFRESH_INTERVAL = 16; 
 
+// System state read once and refreshed from notifications, so neither the
+// render loop nor the position timer touches the registry
+bool g_isDarkTheme = true;      // IsTaskbarDarkMode(), refreshed on WM_SETTINGCHANGE
+int g_autoStartState = -1;      // Autostart value last written to the Run key, -1 before the first sync
+RECT g_windowRect = {0};        // Where UpdatePosition last placed the window
+
+// DPI of the monitor the window is on. Window and font sizes in the config
+// are at 96 DPI and scaled by it; the render target itself stays at 96 DPI,
+// so one DIP is one pixel of the surface.
+UINT g_dpi = USER_DEFAULT_SCREEN_DPI;
+int ScaleForDpi(int value) { return MulDiv(value, (int)g_dpi, USER_DEFAULT_SCREEN_DPI); }
+
 std::wstring Utf8ToWide(const std::string& str) {
     if (str.empty()) return L"";
     int size = MultiByteToWideChar(CP_UTF8, 0, str.c_str(), (int)str.size(), NULL, 0);
@@ -51,10 +89,18 @@ public:
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 void InitD2D(HWND hWnd);
+void RebuildTextFormat();
 void CleanupD2D();
+bool EnsureRenderContext(int w, int h);
+void ReleaseSurface();
+void ReleaseDeviceResources();
+IDWriteTextLayout* GetTextLayout(TextLayoutSlot& slot, const std::wstring& text, uint64_t version, int64_t line, float w, float h);
+bool MeasureWords(TextLayoutSlot& slot, std::wstring_view lineText, LyricTimeline::LineWords words);
+void ReleaseTextLayout(TextLayoutSlot& slot);
 void Render(HWND hWnd);
 void UpdatePosition(HWND hWnd);
 void SetAutoStart(bool enable);
+void SyncAutoStart();
 void InitWebSocketCallbacks();
 
 D2D1::ColorF ColorRefToD2D(COLORREF color, float alpha = 1.0f) {
@@ -81,7 +127,7 @@ void InitWebSocketCallbacks() {
     callbacks.onStatusChange = [](bool isPlaying) { g_lyricMgr.UpdatePlayStatus(isPlaying); };
     callbacks.onSongChange = [](const SPlayerProtocol::SongInfo& info) { g_lyricMgr.UpdateSongInfo(info); };
     callbacks.onProgressChange = [](const SPlayerProtocol::ProgressInfo& info) { g_lyricMgr.UpdateProgress(info.currentTime); };
-    callbacks.onLyricChange = [](const SPlayerProtocol::LyricData& data) { g_lyricMgr.UpdateLyrics(data); };
+    callbacks.onLyricChange = [](SPlayerProtocol::LyricData&& data) { g_lyricMgr.UpdateLyrics(std::move(data)); };
     callbacks.onError = [](const std::string& msg) { 
         std::wstring wmsg = L"[DesktopLyric] Error: " + Utf8ToWide(msg) + L"\n";
         OutputDebugStringW(wmsg.c_str()); 
@@ -97,6 +143,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
     GetModuleFileNameW(NULL, path, MAX_PATH);
     PathRemoveFileSpecW(path);
     g_config.Load(path);
+    g_lyricMgr.SetOptions({ g_config.Data().enableYrc, g_config.Data().lyricOffset });
 
     WNDCLASSEXW wc = { sizeof(WNDCLASSEXW), CS_HREDRAW | CS_VREDRAW, WndProc, 0, 0, hInstance, 
                        LoadIcon(nullptr, IDI_APPLICATION), LoadCursor(nullptr, IDC_ARROW), 
@@ -110,8 +157,15 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 
     if (!hWnd) return 0;
 
+    // Later changes arrive as WM_DPICHANGED (the manifest declares per-monitor awareness)
+    HDC screen = GetDC(hWnd);
+    g_dpi = (UINT)GetDeviceCaps(screen, LOGPIXELSY);
+    ReleaseDC(hWnd, screen);
+
+    g_isDarkTheme = IsTaskbarDarkMode();
     InitD2D(hWnd);
     UpdatePosition(hWnd);
+    SyncAutoStart();
     InitWebSocketCallbacks();
     g_wsClient.Start(g_config.Data().wsPort);
 
@@ -143,39 +197,62 @@ void SetAutoStart(bool enable) {
     }
 }
 
+// Writes the Run key only when the setting differs from what was last written
+void SyncAutoStart() {
+    int wanted = g_config.Data().autoStart ? 1 : 0;
+    if (wanted == g_autoStartState) return;
+    SetAutoStart(wanted != 0);
+    g_autoStartState = wanted;
+}
+
 void UpdatePosition(HWND hWnd) {
     const auto& config = g_config.Data();
-    HWND hTaskbar = FindWindowW(L"Shell_TrayWnd", nullptr);
-    if (!hTaskbar) return;
+    APPBARDATA abd = { sizeof(APPBARDATA) };
+    if (!SHAppBarMessage(ABM_GETTASKBARPOS, &abd)) return;
 
-    RECT rcT; GetWindowRect(hTaskbar, &rcT);
+    RECT rcT = abd.rc;
     int tbH = rcT.bottom - rcT.top;
     int tbW = rcT.right - rcT.left;
 
-    int width = config.displayWidth;
-    int winHeight = config.desktopDualLine ? 48 : 32; 
+    int width = ScaleForDpi(config.displayWidth);
+    int winHeight = ScaleForDpi(config.desktopDualLine ? 48 : 32);
+    int xOffset = ScaleForDpi(config.desktopXOffset);
 
-    int winX = rcT.left + config.desktopXOffset;
+    int winX = rcT.left + xOffset;
     int winY = rcT.top + (tbH - winHeight) / 2;
 
     if (tbW < tbH) {
         winX = rcT.left + (tbW - width) / 2;
-        winY = rcT.top + config.desktopXOffset;
+        winY = rcT.top + xOffset;
     }
 
+    RECT rcWin = { winX, winY, winX + width, winY + winHeight };
+    if (EqualRect(&rcWin, &g_windowRect)) {
+        // Unchanged: only keep it above the taskbar
+        SetWindowPos(hWnd, HWND_TOPMOST, 0, 0, 0, 0, SWP_NOMOVE | SWP_NOSIZE | SWP_SHOWWINDOW | SWP_NOACTIVATE);
+        return;
+    }
+
+    g_windowRect = rcWin;
     SetWindowPos(hWnd, HWND_TOPMOST, winX, winY, width, winHeight,  SWP_SHOWWINDOW | SWP_NOACTIVATE);
     Render(hWnd);
-    SetAutoStart(config.autoStart);
 }
 
 void InitD2D(HWND hWnd) {
     if (g_pD2DFactory) CleanupD2D();
     D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &g_pD2DFactory);
-    D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties(D2D1_RENDER_TARGET_TYPE_DEFAULT, D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED));
-    g_pD2DFactory->CreateDCRenderTarget(&props, &g_pDCRenderTarget);
-    g_pDCRenderTarget->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_CLEARTYPE);
     DWriteCreateFactory(DWRITE_FACTORY_TYPE_SHARED, __uuidof(IDWriteFactory), (IUnknown**)&g_pDWriteFactory);
-    
+    RebuildTextFormat();
+}
+
+// The text format at the configured font and the current DPI. Layouts made
+// with the previous one are dropped and rebuilt on the next frame.
+void RebuildTextFormat() {
+    ReleaseTextLayout(g_layoutCurrent); ReleaseTextLayout(g_layoutSecond);
+    if (g_pTextFormat) g_pTextFormat->Release();
+    g_pTextFormat = nullptr;
+    if (!g_pDWriteFactory) return;
+
     // Robust Font Fallback: Try User Font -> YaHei UI -> YaHei -> Segoe UI -> Arial
     const auto& config = g_config.Data();
     std::vector<std::wstring> fontList;
@@ -190,7 +267,7 @@ void InitD2D(HWND hWnd) {
             name.c_str(), nullptr,
             config.fontWeightBold ? DWRITE_FONT_WEIGHT_BOLD : DWRITE_FONT_WEIGHT_NORMAL,
             DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL,
-            (float)config.fontSize * 1.33f, L"zh-CN", &g_pTextFormat
+            (float)config.fontSize * 1.33f * g_dpi / USER_DEFAULT_SCREEN_DPI, L"zh-CN", &g_pTextFormat
         );
         if (SUCCEEDED(hr) && g_pTextFormat) break;
     }
@@ -202,38 +279,139 @@ void InitD2D(HWND hWnd) {
     }
 }
 
+// Creates whatever of the render target, brushes and DIB is missing or the
+// wrong size; a no-op on the steady-state frame
+bool EnsureRenderContext(int w, int h) {
+    if (!g_pD2DFactory || w <= 0 || h <= 0) return false;
+
+    if (!g_pDCRenderTarget) {
+        D2D1_RENDER_TARGET_PROPERTIES props = D2D1::RenderTargetProperties(D2D1_RENDER_TARGET_TYPE_DEFAULT, D2D1::PixelFormat(DXGI_FORMAT_B8G8R8A8_UNORM, D2D1_ALPHA_MODE_PREMULTIPLIED),
+            (float)USER_DEFAULT_SCREEN_DPI, (float)USER_DEFAULT_SCREEN_DPI);
+        if (FAILED(g_pD2DFactory->CreateDCRenderTarget(&props, &g_pDCRenderTarget))) return false;
+        g_pDCRenderTarget->SetTextAntialiasMode(D2D1_TEXT_ANTIALIAS_MODE_CLEARTYPE);
+        g_render.bound = false;
+    }
+
+    if (!g_render.pNormal) {
+        // Colors are set per frame with SetColor; only the objects persist
+        g_pDCRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0, 0, 0), &g_render.pNormal);
+        g_pDCRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0, 0, 0), &g_render.pHi);
+        g_pDCRenderTarget->CreateSolidColorBrush(D2D1::ColorF(0, 0, 0), &g_render.pInactive);
+        if (!g_render.pNormal || !g_render.pHi || !g_render.pInactive) { ReleaseDeviceResources(); return false; }
+    }
+
+    if (!g_render.memDC || g_render.width != w || g_render.height != h) {
+        ReleaseSurface();
+        g_render.memDC = CreateCompatibleDC(NULL);
+        BITMAPINFO bmi = {sizeof(BITMAPINFOHEADER), w, -h, 1, 32, BI_RGB};
+        void* pBits; g_render.dib = CreateDIBSection(g_render.memDC, &bmi, DIB_RGB_COLORS, &pBits, NULL, 0);
+        if (!g_render.memDC || !g_render.dib) { ReleaseSurface(); return false; }
+        g_render.oldBitmap = SelectObject(g_render.memDC, g_render.dib);
+        g_render.width = w; g_render.height = h;
+
+        wchar_t buf[128];
+        swprintf_s(buf, L"[DesktopLyric] Render surface %dx%d, GDI objects: %lu\n", w, h, GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS));
+        OutputDebugStringW(buf);
+    }
+
+    if (!g_render.bound) {
+        RECT rc = {0, 0, w, h};
+        if (FAILED(g_pDCRenderTarget->BindDC(g_render.memDC, &rc))) return false;
+        g_render.bound = true;
+    }
+    return true;
+}
+
+void ReleaseSurface() {
+    if (g_render.memDC) { SelectObject(g_render.memDC, g_render.oldBitmap); DeleteDC(g_render.memDC); }
+    if (g_render.dib) DeleteObject(g_render.dib);
+    g_render.memDC = nullptr; g_render.dib = nullptr; g_render.oldBitmap = nullptr;
+    g_render.width = g_render.height = 0;
+    g_render.bound = false;
+}
+
+// Everything tied to the render target; recreated on the next frame
+void ReleaseDeviceResources() {
+    if (g_render.pNormal) g_render.pNormal->Release(); if (g_render.pHi) g_render.pHi->Release(); if (g_render.pInactive) g_render.pInactive->Release();
+    g_render.pNormal = nullptr; g_render.pHi = nullptr; g_render.pInactive = nullptr;
+    if (g_pDCRenderTarget) g_pDCRenderTarget->Release();
+    g_pDCRenderTarget = nullptr;
+    g_render.bound = false;
+}
+
+// The line's layout, created only when the line (or the box it is laid out
+// in) changes; the text format is fixed until CleanupD2D drops the slots
+IDWriteTextLayout* GetTextLayout(TextLayoutSlot& slot, const std::wstring& text, uint64_t version, int64_t line, float w, float h) {
+    if (slot.layout && slot.lyricsVersion == version && slot.lineIndex == line && slot.width == w && slot.height == h)
+        return slot.layout;
+
+    ReleaseTextLayout(slot);
+    if (text.empty() || !g_pDWriteFactory || !g_pTextFormat) return nullptr;
+    if (FAILED(g_pDWriteFactory->CreateTextLayout(text.c_str(), (UINT32)text.length(), g_pTextFormat, w, h, &slot.layout)))
+        return nullptr;
+
+    slot.lyricsVersion = version; slot.lineIndex = line;
+    slot.width = w; slot.height = h;
+    return slot.layout;
+}
+
+// Word edges of a YRC line from the cached layout's hit-testing, once per line.
+// The words are views into the line's text, which gives their offsets.
+bool MeasureWords(TextLayoutSlot& slot, std::wstring_view lineText, LyricTimeline::LineWords words) {
+    if (!slot.layout || words.empty()) return false;
+    if (slot.wordX.size() == words.size() + 1) return true;
+
+    slot.wordX.clear();
+    DWRITE_HIT_TEST_METRICS metrics;
+    float x, y;
+    for (size_t i = 0; i < words.size(); ++i) {
+        std::wstring_view text = words[i].text;
+        if (text.data() < lineText.data() || text.data() + text.length() > lineText.data() + lineText.length()) {
+            slot.wordX.clear();
+            return false;
+        }
+        slot.layout->HitTestTextPosition((UINT32)(text.data() - lineText.data()), FALSE, &x, &y, &metrics);
+        slot.wordX.push_back(x);
+    }
+    std::wstring_view last = words[words.size() - 1].text;
+    slot.layout->HitTestTextPosition((UINT32)(last.data() - lineText.data() + last.length() - 1), TRUE, &x, &y, &metrics);
+    slot.wordX.push_back(x);
+    return true;
+}
+
+void ReleaseTextLayout(TextLayoutSlot& slot) {
+    if (slot.layout) slot.layout->Release();
+    slot = TextLayoutSlot();
+}
+
 void Render(HWND hWnd) {
-    if (!g_pDCRenderTarget) return;
     RECT rc; GetClientRect(hWnd, &rc);
     int w = rc.right, h = rc.bottom;
-    
-    HDC hdcS = GetDC(NULL), hdcM = CreateCompatibleDC(hdcS);
-    BITMAPINFO bmi = {sizeof(BITMAPINFOHEADER), w, -h, 1, 32, BI_RGB};
-    void* pBits; HBITMAP hbmp = CreateDIBSection(hdcM, &bmi, DIB_RGB_COLORS, &pBits, NULL, 0);
-    HBITMAP hOld = (HBITMAP)SelectObject(hdcM, hbmp);
+    if (!EnsureRenderContext(w, h)) return;
 
-    g_pDCRenderTarget->BindDC(hdcM, &rc);
     g_pDCRenderTarget->BeginDraw();
     g_pDCRenderTarget->Clear(D2D1::ColorF(0,0,0, 0.0f));
 
     const auto& config = g_config.Data();
-    ID2D1SolidColorBrush *pNormal, *pHi, *pInactive;
+    ID2D1SolidColorBrush *pHi = g_render.pHi, *pInactive = g_render.pInactive;
     
-    bool isDark = IsTaskbarDarkMode();
+    bool isDark = g_isDarkTheme;
     COLORREF baseColor = isDark ? RGB(255, 255, 255) : RGB(0, 0, 0);
     COLORREF highlight = config.highlightColor;
     
     // Use OPAQUE brushes to ensure visibility
     // Window transparency is handled by UpdateLayeredWindow
-    g_pDCRenderTarget->CreateSolidColorBrush(ColorRefToD2D(baseColor, 0.8f), &pNormal); // Slightly dim for non-highlight
-    g_pDCRenderTarget->CreateSolidColorBrush(ColorRefToD2D(highlight, 1.0f), &pHi);    // Highlight
-    g_pDCRenderTarget->CreateSolidColorBrush(ColorRefToD2D(baseColor, 0.5f), &pInactive);
-
-    int64_t curIdx = g_lyricMgr.GetCurrentLineIndex();
-    if (curIdx != g_lastLyricIndex) {
-        g_lastLine = g_currentLine; g_currentLine = g_lyricMgr.GetCurrentLyricText();
-        g_secondLine = config.secondLineType == 0 ? g_lyricMgr.GetNextLyricText() : g_lyricMgr.GetCurrentTranslation();
-        g_scrollPos = 0.0f; g_lastLyricIndex = curIdx;
+    g_render.pNormal->SetColor(ColorRefToD2D(baseColor, 0.8f)); // Slightly dim for non-highlight
+    pHi->SetColor(ColorRefToD2D(highlight, 1.0f));              // Highlight
+    pInactive->SetColor(ColorRefToD2D(baseColor, 0.5f));
+
+    LyricManager::Frame frame = g_lyricMgr.GetFrame();
+    int64_t curIdx = frame.lineIndex;
+    uint64_t version = frame.lyrics->version;
+    if (curIdx != g_lastLyricIndex || version != g_lastLyricsVersion) {
+        g_lastLine = g_currentLine; g_currentLine = frame.CurrentLineText();
+        g_secondLine = config.secondLineType == 0 ? frame.NextLineText() : frame.CurrentTranslation();
+        g_scrollPos = 0.0f; g_lastLyricIndex = curIdx; g_lastLyricsVersion = version;
     }
     
     // Ensure default text is shown if empty
@@ -242,27 +420,47 @@ void Render(HWND hWnd) {
     if (g_scrollPos < 1.0f) g_scrollPos += 0.05f;
 
     float lineH = (float)h / (config.desktopDualLine ? 2.0f : 1.0f);
-    float offsetV = (1.0f - g_scrollPos) * 6.0f; 
+    float offsetV = (1.0f - g_scrollPos) * 6.0f * g_dpi / USER_DEFAULT_SCREEN_DPI;
 
     // Helper to draw text
-    auto DrawSingle = [&](const std::wstring& txt, float y, bool isCurrentLine) {
-        if (txt.empty() || !g_pTextFormat) return;
-        D2D1_RECT_F r = D2D1::RectF(0, y, (float)w, y + lineH);
-        
-        // Simplified rendering for stability first
-        // TODO: Restore YRC per-word highlighting if needed, but text first
-        g_pDCRenderTarget->DrawText(txt.c_str(), (UINT32)txt.length(), g_pTextFormat, r, isCurrentLine ? pHi : pInactive);
+    LyricTimeline::LineWords words = frame.CurrentYrcWords();
+    auto DrawSingle = [&](TextLayoutSlot& slot, const std::wstring& txt, float y, bool isCurrentLine) {
+        IDWriteTextLayout* layout = GetTextLayout(slot, txt, version, curIdx, (float)w, lineH);
+        if (!layout) return;
+        D2D1_POINT_2F origin = D2D1::Point2F(0, y);
+
+        if (!isCurrentLine || !MeasureWords(slot, frame.CurrentLineText(), words)) {
+            g_pDCRenderTarget->DrawTextLayout(origin, layout, isCurrentLine ? pHi : pInactive);
+            return;
+        }
+
+        // YRC: the line in the normal color, then once more in the highlight
+        // color clipped at the highlight edge
+        const LyricManager::Highlight& hl = frame.highlight;
+        float splitX = slot.wordX[hl.completedWords];
+        if ((int)hl.completedWords == hl.activeWord)
+            splitX += (slot.wordX[hl.activeWord + 1] - slot.wordX[hl.activeWord]) * hl.activeProgress;
+
+        g_pDCRenderTarget->DrawTextLayout(origin, layout, g_render.pNormal);
+        if (splitX > 0.0f) {
+            g_pDCRenderTarget->PushAxisAlignedClip(D2D1::RectF(0, 0, splitX, (float)h), D2D1_ANTIALIAS_MODE_ALIASED);
+            g_pDCRenderTarget->DrawTextLayout(origin, layout, pHi);
+            g_pDCRenderTarget->PopAxisAlignedClip();
+        }
     };
 
     if (config.desktopDualLine) { 
-        DrawSingle(g_currentLine, 0 - offsetV, true); 
-        DrawSingle(g_secondLine, lineH - offsetV, false); 
-    } else { 
-        DrawSingle(g_currentLine, 0 - offsetV, true); 
+        DrawSingle(g_layoutCurrent, g_currentLine, 0 - offsetV, true);
+        DrawSingle(g_layoutSecond, g_secondLine, lineH - offsetV, false);
+    } else {
+        DrawSingle(g_layoutCurrent, g_currentLine, 0 - offsetV, true);
     }
     
-    if (pNormal) pNormal->Release(); if (pHi) pHi->Release(); if (pInactive) pInactive->Release();
-    g_pDCRenderTarget->EndDraw();
+    if (g_pDCRenderTarget->EndDraw() == D2DERR_RECREATE_TARGET) {
+        // Device lost: drop the target and brushes, rebuild them next frame
+        ReleaseDeviceResources();
+        return;
+    }
     
     // Apply User's Window Transparency preference
     // Default to 255 if configured value is weird (e.g. 0)
@@ -270,14 +468,15 @@ void Render(HWND hWnd) {
     
     BLENDFUNCTION bl = {AC_SRC_OVER, 0, alpha, AC_SRC_ALPHA};
     POINT ptS = {0,0}; SIZE sz = {w,h}; RECT rcW; GetWindowRect(hWnd, &rcW); POINT ptD = {rcW.left, rcW.top};
-    UpdateLayeredWindow(hWnd, hdcS, &ptD, &sz, hdcM, &ptS, 0, &bl, ULW_ALPHA);
-    SelectObject(hdcM, hOld); DeleteObject(hbmp); DeleteDC(hdcM); ReleaseDC(NULL, hdcS);
+    UpdateLayeredWindow(hWnd, NULL, &ptD, &sz, g_render.memDC, &ptS, 0, &bl, ULW_ALPHA);
 }
 
 void CleanupD2D() {
+    ReleaseTextLayout(g_layoutCurrent); ReleaseTextLayout(g_layoutSecond);
+    ReleaseDeviceResources(); ReleaseSurface();
     if (g_pTextFormat) g_pTextFormat->Release(); if (g_pDWriteFactory) g_pDWriteFactory->Release();
-    if (g_pDCRenderTarget) g_pDCRenderTarget->Release(); if (g_pD2DFactory) g_pD2DFactory->Release();
-    g_pTextFormat = nullptr; g_pDWriteFactory = nullptr; g_pDCRenderTarget = nullptr; g_pD2DFactory = nullptr;
+    if (g_pD2DFactory) g_pD2DFactory->Release();
+    g_pTextFormat = nullptr; g_pDWriteFactory = nullptr; g_pD2DFactory = nullptr;
 }
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
@@ -299,13 +498,31 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         int cmd = TrackPopupMenu(hMenu, TPM_RETURNCMD | TPM_RIGHTBUTTON, pt.x, pt.y, 0, hWnd, nullptr);
         if (cmd == 101) {
             COptionsDialog dlg;
-            if (dlg.DoModal() == IDOK) { CleanupD2D(); InitD2D(hWnd); UpdatePosition(hWnd); }
+            if (dlg.DoModal() == IDOK) { CleanupD2D(); InitD2D(hWnd); UpdatePosition(hWnd); SyncAutoStart(); }
         }
         if (cmd == 102) PostQuitMessage(0);
         DestroyMenu(hMenu);
         return 0;
     }
-    case WM_SETTINGS_CHANGED: CleanupD2D(); InitD2D(hWnd); Render(hWnd); return 0;
+    case WM_SETTINGS_CHANGED: CleanupD2D(); InitD2D(hWnd); UpdatePosition(hWnd); SyncAutoStart(); Render(hWnd); return 0;
+    case WM_DPICHANGED: {
+        // New DPI in wParam; lParam is the window rectangle Windows suggests for it
+        g_dpi = HIWORD(wParam);
+        const RECT* suggested = (const RECT*)lParam;
+        SetWindowPos(hWnd, nullptr, suggested->left, suggested->top, suggested->right - suggested->left,
+                     suggested->bottom - suggested->top, SWP_NOZORDER | SWP_NOACTIVATE);
+        g_windowRect = *suggested;
+        RebuildTextFormat();
+        ReleaseSurface();
+        UpdatePosition(hWnd);   // Back against the taskbar at the sizes for the new DPI
+        return 0;
+    }
+    case WM_SETTINGCHANGE:
+        // Light/dark switch is announced as "ImmersiveColorSet"; taskbar moves and resizes change the work area
+        if (lParam && lstrcmpW((LPCWSTR)lParam, L"ImmersiveColorSet") == 0) { g_isDarkTheme = IsTaskbarDarkMode(); Render(hWnd); }
+        else if (wParam == SPI_SETWORKAREA) UpdatePosition(hWnd);
+        return 0;
+    case WM_DISPLAYCHANGE: UpdatePosition(hWnd); return 0;
     case WM_NCHITTEST: return HTCLIENT; 
     case WM_SETCURSOR: SetCursor(LoadCursor(nullptr, IDC_HAND)); return TRUE;
     case WM_WINDOWPOSCHANGING: {
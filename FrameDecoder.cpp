@@ -0,0 +1,263 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Incremental WebSocket Frame Decoder Implementation
+ */
+
+#include "pch.h"
+#include "FrameDecoder.h"
+#include "WebSocketMask.h"
+#include <algorithm>
+#include <cstring>
+
+// Initial buffer size, grown only when a single frame does not fit
+static const size_t INITIAL_BUFFER_SIZE = 64 * 1024;
+// Don't bother calling recv() for less free space than this
+static const size_t MIN_READ_SIZE = 4096;
+// Default limit for a frame or reassembled message
+static const size_t DEFAULT_MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+// Buffer size kept once an unusually large message has been read
+static const size_t MAX_RETAINED_BUFFER_SIZE = 4 * 1024 * 1024;
+
+FrameDecoder::FrameDecoder()
+    : m_buffer(INITIAL_BUFFER_SIZE)
+    , m_maxMessageSize(DEFAULT_MAX_MESSAGE_SIZE)
+{
+}
+
+void FrameDecoder::Reset()
+{
+    m_readPos = 0;
+    m_writePos = 0;
+    m_needed = 0;
+    m_messageStart = 0;
+    m_messageSize = 0;
+    m_inFragmentedMessage = false;
+    m_discardFragments = false;
+}
+
+// Move the partial message and the unread bytes to the front of the buffer,
+// dropping the consumed frames and the headers between fragments
+void FrameDecoder::Compact()
+{
+    size_t dst = 0;
+    if (HoldsMessage())
+    {
+        if (m_messageStart > 0)
+        {
+            memmove(m_buffer.data(), m_buffer.data() + m_messageStart, m_messageSize);
+            m_bytesCopied += m_messageSize;
+            m_messageStart = 0;
+        }
+        dst = m_messageSize;
+    }
+
+    size_t pending = m_writePos - m_readPos;
+    if (m_readPos > dst)
+    {
+        memmove(m_buffer.data() + dst, m_buffer.data() + m_readPos, pending);
+        m_bytesCopied += pending;
+        m_readPos = dst;
+        m_writePos = dst + pending;
+    }
+}
+
+// Called right after Compact(), so only [0, m_writePos) is live and copied
+void FrameDecoder::Grow(size_t required)
+{
+    std::vector<char> grown((std::max)(m_buffer.size() * 2, required));
+    memcpy(grown.data(), m_buffer.data(), m_writePos);
+    m_bytesCopied += m_writePos;
+    m_buffer.swap(grown);
+}
+
+char* FrameDecoder::PrepareWrite(size_t& available)
+{
+    // Everything consumed: rewind for free, and let go of a buffer that an
+    // unusually large message left behind
+    if (m_readPos == m_writePos && !HoldsMessage())
+    {
+        m_readPos = 0;
+        m_writePos = 0;
+        if (m_buffer.size() > MAX_RETAINED_BUFFER_SIZE)
+            std::vector<char>(INITIAL_BUFFER_SIZE).swap(m_buffer);
+    }
+
+    size_t pending = m_writePos - m_readPos;
+    size_t want = (std::max)(MIN_READ_SIZE, m_needed > pending ? m_needed - pending : 0);
+
+    if (m_buffer.size() - m_writePos < want)
+    {
+        // Reclaim consumed space before growing
+        Compact();
+        if (m_buffer.size() - m_writePos < want)
+            Grow(m_writePos + want);
+    }
+
+    available = m_buffer.size() - m_writePos;
+    return m_buffer.data() + m_writePos;
+}
+
+void FrameDecoder::Commit(size_t n)
+{
+    m_writePos = (std::min)(m_writePos + n, m_buffer.size());
+}
+
+std::string_view FrameDecoder::Pending() const
+{
+    return std::string_view(m_buffer.data() + m_readPos, m_writePos - m_readPos);
+}
+
+void FrameDecoder::Consume(size_t n)
+{
+    m_readPos = (std::min)(m_readPos + n, m_writePos);
+}
+
+bool FrameDecoder::ParseHeader(size_t& headerLen, uint64_t& payloadLen) const
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(m_buffer.data() + m_readPos);
+    size_t available = m_writePos - m_readPos;
+
+    if (available < 2)
+        return false;
+
+    bool masked = (p[1] & 0x80) != 0;
+    payloadLen = p[1] & 0x7F;
+    headerLen = 2;
+
+    if (payloadLen == 126)
+        headerLen += 2;
+    else if (payloadLen == 127)
+        headerLen += 8;
+
+    if (masked)
+        headerLen += 4;
+
+    if (available < headerLen)
+        return false;
+
+    if (payloadLen == 126)
+    {
+        payloadLen = (p[2] << 8) | p[3];
+    }
+    else if (payloadLen == 127)
+    {
+        payloadLen = 0;
+        for (int i = 0; i < 8; i++)
+            payloadLen = (payloadLen << 8) | p[2 + i];
+    }
+
+    return true;
+}
+
+FrameDecoder::Event FrameDecoder::Next(std::string_view& data)
+{
+    while (true)
+    {
+        size_t headerLen = 0;
+        uint64_t payloadLen = 0;
+        if (!ParseHeader(headerLen, payloadLen))
+        {
+            m_needed = headerLen;
+            return Event::NeedMore;
+        }
+
+        if (payloadLen > m_maxMessageSize)
+            return Event::Error;
+
+        size_t frameLen = headerLen + (size_t)payloadLen;
+        if (m_writePos - m_readPos < frameLen)
+        {
+            m_needed = frameLen;
+            return Event::NeedMore;
+        }
+        m_needed = 0;
+
+        unsigned char* frame = reinterpret_cast<unsigned char*>(m_buffer.data() + m_readPos);
+        bool fin = (frame[0] & 0x80) != 0;
+        int opcode = frame[0] & 0x0F;
+        bool masked = (frame[1] & 0x80) != 0;
+        char* payload = m_buffer.data() + m_readPos + headerLen;
+
+        // Server frames should never be masked, but unmask in place if they are
+        if (masked)
+        {
+            unsigned char* bytes = reinterpret_cast<unsigned char*>(payload);
+            ApplyWebSocketMask(bytes, bytes, (size_t)payloadLen, frame + headerLen - 4);
+        }
+
+        m_readPos += frameLen;
+        std::string_view view(payload, (size_t)payloadLen);
+
+        switch (opcode)
+        {
+        case 0x1:  // Text frame
+            if (m_inFragmentedMessage)
+                return Event::Error;
+            if (fin)
+            {
+                // Common case: hand out the payload where it sits
+                data = view;
+                return Event::Text;
+            }
+            // The first fragment stays where it is; the rest join it
+            m_messageStart = (size_t)(payload - m_buffer.data());
+            m_messageSize = view.size();
+            m_inFragmentedMessage = true;
+            m_discardFragments = false;
+            break;
+
+        case 0x2:  // Binary frame, not used by SPlayer
+            if (m_inFragmentedMessage)
+                return Event::Error;
+            if (!fin)
+            {
+                m_inFragmentedMessage = true;
+                m_discardFragments = true;
+            }
+            break;
+
+        case 0x0:  // Continuation frame
+            if (!m_inFragmentedMessage)
+                return Event::Error;
+            if (!m_discardFragments)
+            {
+                if (m_messageSize + view.size() > m_maxMessageSize)
+                    return Event::Error;
+
+                // Close the gap left by the headers (and any control
+                // frames) since the previous fragment
+                char* end = m_buffer.data() + m_messageStart + m_messageSize;
+                if (end != payload)
+                {
+                    memmove(end, payload, view.size());
+                    m_bytesCopied += view.size();
+                }
+                m_messageSize += view.size();
+            }
+            if (fin)
+            {
+                m_inFragmentedMessage = false;
+                if (m_discardFragments)
+                    break;
+                data = std::string_view(m_buffer.data() + m_messageStart, m_messageSize);
+                return Event::Text;
+            }
+            break;
+
+        case 0x8:  // Close
+            data = view;
+            return Event::Close;
+
+        case 0x9:  // Ping
+            if (!fin || payloadLen > 125)
+                return Event::Error;
+            data = view;
+            return Event::Ping;
+
+        default:
+            // Pongs and reserved opcodes
+            break;
+        }
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Incremental WebSocket Frame Decoder
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Platform-neutral decoder for server->client WebSocket frames.
+//
+// Socket bytes are received straight into the decoder's buffer via
+// PrepareWrite()/Commit(). Headers are parsed incrementally, so a frame
+// split across any number of reads is picked up once its last byte lands.
+// The buffer is reused across frames: consumed bytes are reclaimed by
+// rewinding to the start once everything is read, or by sliding the unread
+// tail forward when the free space at the end runs low.
+//
+// A fragmented message is reassembled inside the same buffer: each
+// continuation payload is moved down over the headers in front of it, so
+// the fragments end up back to back behind the first one and the message
+// is handed out where it sits.
+//
+// Views returned by Next() point into the decoder and stay valid until the
+// next Next(), PrepareWrite() or Consume() call.
+class FrameDecoder
+{
+public:
+    enum class Event
+    {
+        NeedMore,   // No complete frame buffered yet
+        Text,       // A complete text message
+        Ping,       // Ping with its application data
+        Close,      // Close frame received
+        Error       // Protocol violation, the connection should be dropped
+    };
+
+    FrameDecoder();
+
+    void Reset();
+
+    // Upper bound for a single frame and for a reassembled message
+    void SetMaxMessageSize(size_t bytes) { m_maxMessageSize = bytes; }
+
+    // Writable window for the next recv() and the number of bytes received into it
+    char* PrepareWrite(size_t& available);
+    void Commit(size_t n);
+
+    // Unparsed bytes, for consuming the HTTP upgrade response ahead of the frames
+    std::string_view Pending() const;
+    void Consume(size_t n);
+
+    Event Next(std::string_view& data);
+
+    // Bytes moved within the decoder so far (sliding, growing, splicing
+    // fragments), not counting the socket's own copy into PrepareWrite()
+    uint64_t BytesCopied() const { return m_bytesCopied; }
+
+private:
+    bool ParseHeader(size_t& headerLen, uint64_t& payloadLen) const;
+    bool HoldsMessage() const { return m_inFragmentedMessage && !m_discardFragments; }
+    void Compact();
+    void Grow(size_t required);
+
+    std::vector<char> m_buffer;
+    size_t m_readPos = 0;
+    size_t m_writePos = 0;
+    size_t m_needed = 0;        // Bytes required to complete the frame at m_readPos
+    size_t m_maxMessageSize;
+
+    // Text fragments received so far, back to back at m_messageStart
+    size_t m_messageStart = 0;
+    size_t m_messageSize = 0;
+    bool m_inFragmentedMessage = false;
+    bool m_discardFragments = false;   // Fragmented message is not text
+
+    uint64_t m_bytesCopied = 0;
+};
@@ -0,0 +1,150 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Cached YRC Line Bitmaps Implementation
+ */
+
+#include "pch.h"
+#include "LineBitmap.h"
+#include <algorithm>
+#include <cstdint>
+
+LineBitmapCache::~LineBitmapCache()
+{
+    Release();
+}
+
+void LineBitmapCache::Release()
+{
+    for (Surface* surface : { &m_normal, &m_highlight })
+    {
+        if (surface->dc != nullptr)
+        {
+            SelectObject(surface->dc, surface->oldBitmap);
+            DeleteDC(surface->dc);
+        }
+        if (surface->bitmap != nullptr)
+            DeleteObject(surface->bitmap);
+        *surface = Surface();
+    }
+
+    m_width = 0;
+    m_height = 0;
+    m_valid = false;
+}
+
+// Bitmaps are only reallocated when a line needs more room than any before
+bool LineBitmapCache::Allocate(HDC dc, int width, int height)
+{
+    if (m_normal.dc != nullptr && width <= m_width && height <= m_height)
+        return true;
+
+    width = (std::max)(width, m_width);
+    height = (std::max)(height, m_height);
+    Release();
+
+    for (Surface* surface : { &m_normal, &m_highlight })
+    {
+        surface->dc = CreateCompatibleDC(dc);
+        surface->bitmap = CreateCompatibleBitmap(dc, width, height);
+        if (surface->dc == nullptr || surface->bitmap == nullptr)
+        {
+            Release();
+            return false;
+        }
+        surface->oldBitmap = SelectObject(surface->dc, surface->bitmap);
+        SetBkMode(surface->dc, TRANSPARENT);
+    }
+
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void LineBitmapCache::Render(const Surface& surface, HFONT font, COLORREF color, LyricTimeline::LineWords words, const LineLayout& layout) const
+{
+    // ETO_OPAQUE with no text fills the rectangle with the background color
+    RECT fill = { 0, 0, m_width, m_height };
+    SetBkColor(surface.dc, m_key.background);
+    ExtTextOutW(surface.dc, 0, 0, ETO_OPAQUE, &fill, nullptr, 0, nullptr);
+
+    HFONT oldFont = (HFONT)SelectObject(surface.dc, font);
+    SetTextColor(surface.dc, color);
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        std::wstring_view text = words[i].text;
+        ExtTextOutW(surface.dc, PADDING + layout.wordX[i], m_key.textY, 0, nullptr, text.data(), (UINT)text.length(), nullptr);
+    }
+    SelectObject(surface.dc, oldFont);
+}
+
+bool LineBitmapCache::Prepare(HDC dc, HFONT font, const Key& key, LyricTimeline::LineWords words, const LineLayout& layout)
+{
+    if (m_valid && key == m_key)
+        return true;
+
+    m_valid = false;
+    if (font == nullptr || !Allocate(dc, layout.totalWidth + PADDING * 2, key.height))
+        return false;
+
+    m_key = key;
+    Render(m_normal, font, key.normalColor, words, layout);
+    Render(m_highlight, font, key.highlightColor, words, layout);
+    m_valid = true;
+    ++m_rebuilds;
+    return true;
+}
+
+void LineBitmapCache::Compose(HDC dc, int destX, int destY, int srcX, int width, int splitX) const
+{
+    int split = (std::max)(0, (std::min)(width, splitX - srcX));
+    if (split > 0)
+        BitBlt(dc, destX, destY, split, m_key.height, m_highlight.dc, PADDING + srcX, 0, SRCCOPY);
+    if (split < width)
+        BitBlt(dc, destX + split, destY, width - split, m_key.height, m_normal.dc, PADDING + srcX + split, 0, SRCCOPY);
+}
+
+COLORREF LineBitmapCache::FlatBackground(HDC dc, const RECT& rect)
+{
+    int width = rect.right - rect.left;
+    int height = rect.bottom - rect.top;
+    if (width <= 0 || height <= 0)
+        return CLR_INVALID;
+
+    // Top-down 32-bit DIB, so the pixels can be scanned in place
+    BITMAPINFO info = {};
+    info.bmiHeader.biSize = sizeof(info.bmiHeader);
+    info.bmiHeader.biWidth = width;
+    info.bmiHeader.biHeight = -height;
+    info.bmiHeader.biPlanes = 1;
+    info.bmiHeader.biBitCount = 32;
+    info.bmiHeader.biCompression = BI_RGB;
+
+    void* bits = nullptr;
+    HBITMAP bitmap = CreateDIBSection(dc, &info, DIB_RGB_COLORS, &bits, nullptr, 0);
+    HDC copyDc = CreateCompatibleDC(dc);
+    COLORREF result = CLR_INVALID;
+    if (bitmap != nullptr && copyDc != nullptr)
+    {
+        HGDIOBJ oldBitmap = SelectObject(copyDc, bitmap);
+        if (BitBlt(copyDc, 0, 0, width, height, dc, rect.left, rect.top, SRCCOPY))
+        {
+            GdiFlush();
+            const uint32_t* pixels = static_cast<const uint32_t*>(bits);
+            uint32_t first = pixels[0] & 0x00FFFFFF;
+            size_t count = (size_t)width * height;
+            size_t i = 1;
+            while (i < count && (pixels[i] & 0x00FFFFFF) == first)
+                ++i;
+            if (i == count)
+                result = RGB((first >> 16) & 0xFF, (first >> 8) & 0xFF, first & 0xFF);
+        }
+        SelectObject(copyDc, oldBitmap);
+    }
+
+    if (copyDc != nullptr)
+        DeleteDC(copyDc);
+    if (bitmap != nullptr)
+        DeleteObject(bitmap);
+    return result;
+}
@@ -0,0 +1,86 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Cached YRC Line Bitmaps
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include "LyricTimeline.h"
+#include "LineLayout.h"
+
+// The current YRC line pre-rendered twice, once in the normal and once in
+// the highlight color, on the item's (flat) background. A line's glyphs
+// only change at line boundaries, so a frame just copies the sung columns
+// from one bitmap and the rest from the other; scrolling only moves the
+// source offset.
+class LineBitmapCache
+{
+public:
+    // Extra columns on both sides for glyph overhang past the measured width
+    static const int PADDING = 2;
+
+    // Everything the pixels depend on
+    struct Key
+    {
+        uint64_t lyricsVersion = 0;
+        int lineIndex = -1;
+        uint64_t fontId = 0;
+        COLORREF normalColor = 0;
+        COLORREF highlightColor = 0;
+        COLORREF background = 0;
+        int height = 0;
+        int textY = 0;          // Baseline offset of the text within the bitmap
+
+        bool operator==(const Key& other) const
+        {
+            return lyricsVersion == other.lyricsVersion && lineIndex == other.lineIndex &&
+                fontId == other.fontId && normalColor == other.normalColor &&
+                highlightColor == other.highlightColor && background == other.background &&
+                height == other.height && textY == other.textY;
+        }
+    };
+
+    LineBitmapCache() = default;
+    ~LineBitmapCache();
+    LineBitmapCache(const LineBitmapCache&) = delete;
+    LineBitmapCache& operator=(const LineBitmapCache&) = delete;
+
+    // Render the line into both bitmaps unless they already hold it.
+    // Returns false if the bitmaps could not be created.
+    bool Prepare(HDC dc, HFONT font, const Key& key, LyricTimeline::LineWords words, const LineLayout& layout);
+
+    // Copy line columns [srcX, srcX + width) to (destX, destY): the columns
+    // left of splitX from the highlight bitmap, the rest from the normal one
+    void Compose(HDC dc, int destX, int destY, int srcX, int width, int splitX) const;
+
+    void Release();
+
+    // The color of every pixel of rect, or CLR_INVALID if they differ (a
+    // gradient, an image, text already drawn). Reads the whole rectangle
+    // back, so it is meant to run once per line rather than every frame.
+    static COLORREF FlatBackground(HDC dc, const RECT& rect);
+
+    // Times the bitmaps were re-rendered
+    uint64_t Rebuilds() const { return m_rebuilds; }
+
+private:
+    struct Surface
+    {
+        HDC dc = nullptr;
+        HBITMAP bitmap = nullptr;
+        HGDIOBJ oldBitmap = nullptr;
+    };
+
+    bool Allocate(HDC dc, int width, int height);
+    void Render(const Surface& surface, HFONT font, COLORREF color, LyricTimeline::LineWords words, const LineLayout& layout) const;
+
+    Surface m_normal;
+    Surface m_highlight;
+    int m_width = 0;            // Allocated size, grown as needed
+    int m_height = 0;
+    Key m_key;
+    bool m_valid = false;
+    uint64_t m_rebuilds = 0;
+};
@@ -0,0 +1,80 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Measured YRC Line Layout Implementation
+ */
+
+#include "pch.h"
+#include "LineLayout.h"
+#include <algorithm>
+#include <utility>
+
+// Reuses the layout's vectors, so re-measuring does not allocate once warm
+void LineLayoutCache::Measure(LineLayout& layout, const LyricTimeline& timeline, uint64_t version, int line, ITextMeasurer& measurer)
+{
+    LyricTimeline::LineWords words = timeline.Words(line);
+
+    layout.lyricsVersion = version;
+    layout.lineIndex = line;
+    layout.fontId = measurer.FontId();
+    layout.wordX.resize(words.size());
+    layout.wordWidth.resize(words.size());
+    layout.totalWidth = 0;
+    layout.height = 0;
+
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        TextExtent extent = measurer.Measure(words[i].text);
+        layout.wordX[i] = layout.totalWidth;
+        layout.wordWidth[i] = extent.cx;
+        layout.totalWidth += extent.cx;
+        layout.height = (std::max)(layout.height, extent.cy);
+    }
+}
+
+const LineLayout& LineLayoutCache::Get(const LyricTimeline& timeline, uint64_t version, int line, ITextMeasurer& measurer)
+{
+    uint64_t font = measurer.FontId();
+    if (m_current.Matches(version, line, font))
+    {
+        ++m_stats.hits;
+        return m_current;
+    }
+
+    if (m_next.Matches(version, line, font))
+    {
+        // Prefetched: the line change is just a swap
+        std::swap(m_current, m_next);
+        ++m_stats.hits;
+        return m_current;
+    }
+
+    ++m_stats.misses;
+    Measure(m_current, timeline, version, line, measurer);
+    return m_current;
+}
+
+const LineLayout* LineLayoutCache::Peek(uint64_t version, int line, uint64_t font) const
+{
+    if (m_current.Matches(version, line, font))
+        return &m_current;
+    if (m_next.Matches(version, line, font))
+        return &m_next;
+    return nullptr;
+}
+
+bool LineLayoutCache::Prefetch(const LyricTimeline& timeline, uint64_t version, int line, int64_t time, ITextMeasurer& measurer)
+{
+    int next = line + 1;
+    if (next < 0 || next >= (int)timeline.LineCount())
+        return false;
+    if (timeline.LineStart(next) - time > PREFETCH_LEAD_MS)
+        return false;
+
+    uint64_t font = measurer.FontId();
+    if (m_next.Matches(version, next, font) || m_current.Matches(version, next, font))
+        return false;
+
+    Measure(m_next, timeline, version, next, measurer);
+    return true;
+}
@@ -0,0 +1,62 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Measured YRC Line Layout
+ */
+
+#pragma once
+
+#include "LyricTimeline.h"
+#include "TextMeasurer.h"
+#include <vector>
+
+// Word geometry of one YRC line in one font. Alignment and scrolling only
+// add an offset to it, so it stays valid until the lyrics or the font change.
+struct LineLayout
+{
+    uint64_t lyricsVersion = 0;
+    int lineIndex = -1;
+    uint64_t fontId = 0;
+
+    std::vector<int> wordX;         // Left edge of each word, relative to the line
+    std::vector<int> wordWidth;
+    int totalWidth = 0;
+    int height = 0;
+
+    bool Matches(uint64_t version, int line, uint64_t font) const
+    {
+        return lineIndex == line && lyricsVersion == version && fontId == font;
+    }
+};
+
+// Layout of the line on screen and of the one after it. The next line is
+// measured ahead of its start from an idle tick (Prefetch), so the frame on
+// which the line changes only swaps the two slots instead of measuring.
+// Slots are keyed by lyrics version and font id, so new lyrics or a font
+// change simply miss; there is nothing to clear.
+class LineLayoutCache
+{
+public:
+    // How long before the next line starts it gets measured
+    static const int64_t PREFETCH_LEAD_MS = 400;
+
+    // Layout of a line; measured right here only if it was not prefetched
+    const LineLayout& Get(const LyricTimeline& timeline, uint64_t version, int line, ITextMeasurer& measurer);
+
+    // Measure the line after `line` once time is within the lead of its start.
+    // Returns true if it measured something.
+    bool Prefetch(const LyricTimeline& timeline, uint64_t version, int line, int64_t time, ITextMeasurer& measurer);
+
+    // The layout if either slot already holds it, without measuring
+    const LineLayout* Peek(uint64_t version, int line, uint64_t font) const;
+
+    // Get() calls served without measuring; prefetches are not counted
+    const MeasureStats& Stats() const { return m_stats; }
+
+private:
+    static void Measure(LineLayout& layout, const LyricTimeline& timeline, uint64_t version, int line, ITextMeasurer& measurer);
+
+    LineLayout m_current;
+    LineLayout m_next;
+    MeasureStats m_stats;
+};
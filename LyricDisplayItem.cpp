@@ -9,10 +9,32 @@
 #include "LyricManager.h"
 #include "WebSocketClient.h"
 #include "Config.h"
+#include "PlaybackClock.h"
+#include <algorithm>
 
 // Static instance pointer for timer callback
 static LyricDisplayItem* g_pLyricItem = nullptr;
 
+// Measures with whatever font is selected into the DC
+class GdiTextMeasurer : public ITextMeasurer
+{
+public:
+    GdiTextMeasurer(HDC dc, uint64_t fontId) : m_dc(dc), m_fontId(fontId) {}
+
+    TextExtent Measure(std::wstring_view text) override
+    {
+        SIZE size = { 0, 0 };
+        GetTextExtentPoint32W(m_dc, text.data(), (int)text.length(), &size);
+        return { size.cx, size.cy };
+    }
+
+    uint64_t FontId() const override { return m_fontId; }
+
+private:
+    HDC m_dc;
+    uint64_t m_fontId;
+};
+
 LyricDisplayItem::LyricDisplayItem()
 {
     g_pLyricItem = this;
@@ -22,12 +44,15 @@ LyricDisplayItem::~LyricDisplayItem()
 {
     StopHighFreqRefresh();
     g_pLyricItem = nullptr;
-    
-    if (m_font != nullptr)
+
+    if (m_measureDc != nullptr)
     {
-        DeleteObject(m_font);
-        m_font = nullptr;
+        DeleteDC(m_measureDc);
+        m_measureDc = nullptr;
     }
+
+    ReleaseFont(m_font);
+    ReleaseFont(m_dualFont);
 }
 
 const wchar_t* LyricDisplayItem::GetItemName() const
@@ -87,60 +112,91 @@ HFONT LyricDisplayItem::GetFont(HDC hDC) const
         }
     }
 
+    return AcquireFont(m_font, hDC, g_config.Data().fontSize);
+}
+
+// Returns the font for the current face, weight and DPI at the given point
+// size, creating it only when one of those changed since the last call
+HFONT LyricDisplayItem::AcquireFont(CachedFont& font, HDC hDC, int pointSize) const
+{
     const auto& config = g_config.Data();
+    int dpi = GetDeviceCaps(hDC, LOGPIXELSY);
 
-    if (m_font == nullptr ||
-        m_lastFontSize != config.fontSize ||
-        m_lastFontName != config.fontName ||
-        m_lastFontBold != config.fontWeightBold)
+    if (font.handle != nullptr &&
+        font.size == pointSize &&
+        font.name == config.fontName &&
+        font.bold == config.fontWeightBold &&
+        font.dpi == dpi)
     {
-        if (m_font != nullptr)
-        {
-            DeleteObject(m_font);
-        }
+        return font.handle;
+    }
 
-        int dpi = GetDeviceCaps(hDC, LOGPIXELSY);
-        int fontHeight = -MulDiv(config.fontSize, dpi, 72);
+    ReleaseFont(font);
+
+    int fontHeight = -MulDiv(pointSize, dpi, 72);
+    int weight = config.fontWeightBold ? FW_BOLD : FW_NORMAL;
+
+    font.handle = CreateFontW(
+        fontHeight,
+        0,
+        0,
+        0,
+        weight,
+        FALSE,
+        FALSE,
+        FALSE,
+        DEFAULT_CHARSET,
+        OUT_DEFAULT_PRECIS,
+        CLIP_DEFAULT_PRECIS,
+        CLEARTYPE_QUALITY,
+        DEFAULT_PITCH | FF_DONTCARE,
+        config.fontName.c_str()
+    );
+
+    font.id = MakeFontId(config.fontName, fontHeight, weight);
+    font.size = pointSize;
+    font.name = config.fontName;
+    font.bold = config.fontWeightBold;
+    font.dpi = dpi;
 
-        m_font = CreateFontW(
-            fontHeight,
-            0,
-            0,
-            0,
-            config.fontWeightBold ? FW_BOLD : FW_NORMAL,
-            FALSE,
-            FALSE,
-            FALSE,
-            DEFAULT_CHARSET,
-            OUT_DEFAULT_PRECIS,
-            CLIP_DEFAULT_PRECIS,
-            CLEARTYPE_QUALITY,
-            DEFAULT_PITCH | FF_DONTCARE,
-            config.fontName.c_str()
-        );
+    wchar_t buf[160];
+    swprintf_s(buf, L"[SPlayerLyric] Created font %dpt at %d dpi, GDI objects: %lu\n",
+        pointSize, dpi, GdiObjectCount());
+    OutputDebugStringW(buf);
+
+    return font.handle;
+}
 
-        m_lastFontSize = config.fontSize;
-        m_lastFontName = config.fontName;
-        m_lastFontBold = config.fontWeightBold;
+void LyricDisplayItem::ReleaseFont(CachedFont& font)
+{
+    if (font.handle != nullptr)
+    {
+        DeleteObject(font.handle);
+        font.handle = nullptr;
     }
+}
 
-    return m_font;
+// GDI objects owned by the process; should stay flat while lyrics play
+DWORD LyricDisplayItem::GdiObjectCount()
+{
+    return GetGuiResources(GetCurrentProcess(), GR_GDIOBJECTS);
 }
 
-std::wstring LyricDisplayItem::GetDisplayText() const
+// The view points into the frame's snapshots or the string resource buffer
+std::wstring_view LyricDisplayItem::GetDisplayText(const LyricManager::Frame& frame) const
 {
     if (!g_wsClient.IsConnected())
     {
         return g_config.StringRes(IDS_NOT_CONNECTED);
     }
 
-    std::wstring lyric = g_lyricMgr.GetCurrentLyricText();
+    std::wstring_view lyric = frame.CurrentLineText();
     if (!lyric.empty())
     {
         return lyric;
     }
 
-    std::wstring songInfo = g_lyricMgr.GetSongInfoText();
+    std::wstring_view songInfo = frame.SongInfoText();
     if (!songInfo.empty())
     {
         return songInfo;
@@ -149,6 +205,207 @@ std::wstring LyricDisplayItem::GetDisplayText() const
     return g_config.StringRes(IDS_NO_LYRIC);
 }
 
+// Draws the current YRC line word by word from its layout. Sung words go out
+// in the highlight color and pending ones in the normal color, one
+// ExtTextOutW each; only the active word is drawn twice, the second time
+// clipped to its sung part. Words entirely outside the clip are skipped.
+void LyricDisplayItem::DrawHighlightedWords(const LyricManager::Frame& frame, const LineLayout& layout,
+    int startX, int textY, const RECT& clip, COLORREF normalColor, COLORREF highlightColor)
+{
+    LyricTimeline::LineWords words = frame.CurrentYrcWords();
+    const LyricManager::Highlight& hl = frame.highlight;
+
+    int currentX = startX;
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        int width = layout.wordWidth[i];
+        if (currentX >= clip.right)
+            break;
+        if (currentX + width <= clip.left)
+        {
+            currentX += width;
+            continue;
+        }
+
+        std::wstring_view text = words[i].text;
+        if (i < hl.completedWords)
+        {
+            m_painter.SetColor(highlightColor);
+            m_painter.Draw(currentX, textY, text, &clip);
+        }
+        else
+        {
+            m_painter.SetColor(normalColor);
+            m_painter.Draw(currentX, textY, text, &clip);
+
+            int fillWidth = (int)i == hl.activeWord ? (int)(width * hl.activeProgress) : 0;
+            if (fillWidth > 0)
+            {
+                RECT fill = clip;
+                fill.left = (std::max)(clip.left, currentX);
+                fill.right = (std::min)(clip.right, currentX + fillWidth);
+                if (fill.left < fill.right)
+                {
+                    m_painter.SetColor(highlightColor);
+                    m_painter.Draw(currentX, textY, text, &fill);
+                }
+            }
+        }
+
+        currentX += width;
+    }
+}
+
+LyricDisplayItem::RenderKey LyricDisplayItem::MakeRenderKey(const LyricManager::Frame& frame) const
+{
+    RenderKey key;
+    key.lyricsVersion = frame.lyrics->version;
+    key.songVersion = frame.song->version;
+    key.lineIndex = frame.lineIndex;
+    key.isPlaying = frame.playback.isPlaying;
+    key.isConnected = g_wsClient.IsConnected();
+    key.completedWords = frame.highlight.completedWords;
+    key.activeWord = frame.highlight.activeWord;
+
+    if (key.activeWord >= 0)
+    {
+        const LineLayout* layout = PeekLayout(frame);
+        if (layout != nullptr && (size_t)key.activeWord < layout->wordWidth.size())
+            key.fillWidth = (int)(layout->wordWidth[key.activeWord] * frame.highlight.activeProgress);
+        else
+            key.fillWidth = -1;
+    }
+    return key;
+}
+
+// Whether a paint now would differ from the last one: another line or song
+// info, a connection change, another pixel of highlight, or an animation
+// (line transition, scrolling) moving
+bool LyricDisplayItem::NeedsRepaint(const LyricManager::Frame& frame) const
+{
+    if (AnimationIntervalMs() == 0)
+        return true;
+
+    RenderKey key = MakeRenderKey(frame);
+    return key.fillWidth < 0 || !(key == m_drawnKey);
+}
+
+// Layout of the frame's line in the active mode's font, if already measured
+const LineLayout* LyricDisplayItem::PeekLayout(const LyricManager::Frame& frame) const
+{
+    if (g_config.Data().desktopDualLine)
+        return m_dualLayouts.Peek(frame.lyrics->version, frame.lineIndex, m_dualFont.id);
+    return m_layouts.Peek(frame.lyrics->version, frame.lineIndex, m_font.id);
+}
+
+// Milliseconds until an animation next moves: 0 while the line transition
+// or a scroll is in motion, the rest of the pause while a scroll holds at an
+// end, -1 when nothing animates
+int64_t LyricDisplayItem::AnimationIntervalMs() const
+{
+    if (m_inTransition)
+        return 0;
+    if (m_scrollCycleLength == 0)
+        return -1;
+
+    ULONGLONG now = GetTickCount64();
+    return now < m_scrollStillUntil ? (int64_t)(m_scrollStillUntil - now) : 0;
+}
+
+RefreshScheduler::Input LyricDisplayItem::MakeRefreshInput(const LyricManager::Frame& frame) const
+{
+    RefreshScheduler::Input input;
+    input.time = frame.currentTime;
+    input.animationMs = AnimationIntervalMs();
+
+    if (frame.timeline == nullptr)
+        return input;
+
+    size_t nextLine = (size_t)(frame.lineIndex + 1);
+    if (nextLine < frame.timeline->LineCount())
+        input.nextLineStart = frame.timeline->LineStart(nextLine);
+
+    LyricTimeline::LineWords words = frame.CurrentYrcWords();
+    int active = frame.highlight.activeWord;
+    if (active >= 0 && (size_t)active < words.size())
+    {
+        LyricTimeline::Word word = words[active];
+        const LineLayout* layout = PeekLayout(frame);
+
+        input.hasActiveWord = true;
+        input.wordStart = word.startTime;
+        input.wordDuration = word.duration;
+        input.wordWidth = layout != nullptr && (size_t)active < layout->wordWidth.size() ? layout->wordWidth[active] : 0;
+        if ((size_t)active + 1 < words.size())
+            input.nextWordStart = words[active + 1].startTime;
+    }
+    return input;
+}
+
+// Composes the current line from the cached normal and highlight bitmaps,
+// split at the highlight's x position. The bitmaps carry their own
+// background, so this only works on a flat one; returns false otherwise and
+// the caller draws the words directly.
+bool LyricDisplayItem::DrawLineBitmap(HDC dc, const LyricManager::Frame& frame, const LineLayout& layout,
+    int startX, int textY, const RECT& clip, bool darkMode, COLORREF normalColor, COLORREF highlightColor)
+{
+    // The whole clip area is read back only when the line, the theme or the
+    // position changes; frames in between reuse the answer without touching
+    // the screen
+    BackgroundSample& sample = m_background;
+    if (!sample.Matches(frame.lyrics->version, frame.lineIndex, darkMode, normalColor, highlightColor, clip))
+    {
+        sample.lyricsVersion = frame.lyrics->version;
+        sample.lineIndex = frame.lineIndex;
+        sample.darkMode = darkMode;
+        sample.normalColor = normalColor;
+        sample.highlightColor = highlightColor;
+        sample.clip = clip;
+        sample.color = LineBitmapCache::FlatBackground(dc, clip);
+    }
+
+    COLORREF background = sample.color;
+    if (background == CLR_INVALID)
+        return false;
+
+    LineBitmapCache::Key key;
+    key.lyricsVersion = frame.lyrics->version;
+    key.lineIndex = frame.lineIndex;
+    key.fontId = m_font.id;
+    key.normalColor = normalColor;
+    key.highlightColor = highlightColor;
+    key.background = background;
+    key.height = clip.bottom - clip.top;
+    key.textY = textY - clip.top;
+
+    LyricTimeline::LineWords words = frame.CurrentYrcWords();
+    if (!m_lineBitmap.Prepare(dc, m_font.handle, key, words, layout))
+        return false;
+
+    // Highlight edge in line coordinates, as DrawHighlightedWords would put it
+    const LyricManager::Highlight& hl = frame.highlight;
+    int splitX = layout.totalWidth;
+    if (hl.completedWords < words.size())
+    {
+        splitX = layout.wordX[hl.completedWords];
+        if ((int)hl.completedWords == hl.activeWord)
+            splitX += (int)(layout.wordWidth[hl.activeWord] * hl.activeProgress);
+    }
+
+    int left = (std::max)(startX - LineBitmapCache::PADDING, (int)clip.left);
+    int right = (std::min)(startX + layout.totalWidth + LineBitmapCache::PADDING, (int)clip.right);
+    if (left < right)
+        m_lineBitmap.Compose(dc, left, clip.top, left - startX, right - left, splitX);
+    return true;
+}
+
+// Extent of a whole string in the font selected into the DC
+TextExtent LyricDisplayItem::MeasureText(HDC dc, uint64_t fontId, std::wstring_view text)
+{
+    GdiTextMeasurer measurer(dc, fontId);
+    return m_textCache.Measure(measurer, text);
+}
+
 void LyricDisplayItem::UpdateScrollAnimation(int textWidth, int areaWidth)
 {
     if (!g_config.Data().enableScrolling || textWidth <= areaWidth)
@@ -156,6 +413,7 @@ void LyricDisplayItem::UpdateScrollAnimation(int textWidth, int areaWidth)
         m_scrollOffset = 0;
         m_scrollStartTime = 0;
         m_scrollCycleLength = 0;
+        m_scrollStillUntil = 0;
         return;
     }
 
@@ -183,10 +441,12 @@ void LyricDisplayItem::UpdateScrollAnimation(int textWidth, int areaWidth)
     // Calculate position in cycle
     float cyclePos = (float)((now - m_scrollStartTime) % (ULONGLONG)cycleDuration);
     
+    m_scrollStillUntil = 0;
     if (cyclePos < pauseDuration)
     {
         // Pause at start
         m_scrollOffset = 0;
+        m_scrollStillUntil = now + (ULONGLONG)(pauseDuration - cyclePos);
     }
     else if (cyclePos < pauseDuration + scrollDuration)
     {
@@ -200,6 +460,7 @@ void LyricDisplayItem::UpdateScrollAnimation(int textWidth, int areaWidth)
     {
         // Pause at end
         m_scrollOffset = (float)maxOffset;
+        m_scrollStillUntil = now + (ULONGLONG)(pauseDuration * 2.0f + scrollDuration - cyclePos);
     }
     else
     {
@@ -214,9 +475,30 @@ void LyricDisplayItem::DrawItem(void* hDC, int x, int y, int w, int h, bool dark
 {
     HDC dc = static_cast<HDC>(hDC);
     const auto& config = g_config.Data();
+    int64_t drawStartUs = PlaybackClock::NowUs();
+
+    // One consistent view of the lyrics and playback state for the whole frame
+    LyricManager::Frame frame = g_lyricMgr.GetFrame();
+    m_itemRect = { x, y, x + w, y + h };
+
+    // New lyrics: report how the measurement caches did and drop the old strings
+    if (frame.lyrics->version != m_measureVersion)
+    {
+        const MeasureStats& text = m_textCache.Stats();
+        const MeasureStats& layout = m_layouts.Stats();
+        const MeasureStats& dual = m_dualLayouts.Stats();
+        wchar_t buf[224];
+        swprintf_s(buf, L"[SPlayerLyric] Measure cache: text %llu/%llu (%.1f%%), line %llu/%llu, dual line %llu/%llu hits/misses, GDI objects: %lu\n",
+            text.hits, text.misses, text.HitRate() * 100.0,
+            layout.hits, layout.misses, dual.hits, dual.misses, GdiObjectCount());
+        OutputDebugStringW(buf);
+
+        m_textCache.Clear();
+        m_measureVersion = frame.lyrics->version;
+    }
 
     // Hide when not playing if enabled
-    if (config.hideWhenNotPlaying && (!g_wsClient.IsConnected() || !g_lyricMgr.IsPlaying()))
+    if (config.hideWhenNotPlaying && (!g_wsClient.IsConnected() || !frame.playback.isPlaying))
     {
         return;
     }
@@ -230,64 +512,87 @@ void LyricDisplayItem::DrawItem(void* hDC, int x, int y, int w, int h, bool dark
     }
 
     SetBkMode(dc, TRANSPARENT);
+    m_painter.Begin(dc);
 
     // Check if dual line display is enabled
     if (config.desktopDualLine)
     {
-        DrawDualLine(dc, x, y, w, h, dark_mode);
+        DrawDualLine(dc, frame, x, y, w, h, dark_mode);
     }
     // Check if we have YRC data for highlight rendering
-    else if (config.enableYrc && g_lyricMgr.HasYrcData() && g_wsClient.IsConnected())
+    else if (config.enableYrc && frame.lyrics->data.hasYrc() && g_wsClient.IsConnected())
     {
-        DrawWithYrcHighlight(dc, x, y, w, h, dark_mode);
+        DrawWithYrcHighlight(dc, frame, x, y, w, h, dark_mode);
     }
     else
     {
-        DrawSimpleText(dc, x, y, w, h, dark_mode);
+        DrawSimpleText(dc, frame, x, y, w, h, dark_mode);
+    }
+
+#ifdef SPLAYERLYRIC_GDI_STATS
+    m_gdiStatsCalls += m_painter.Calls();
+    if (++m_gdiStatsFrames == GDI_STATS_FRAMES)
+    {
+        wchar_t buf[96];
+        swprintf_s(buf, L"[SPlayerLyric] GDI text calls: %.1f per frame\n",
+            (double)m_gdiStatsCalls / GDI_STATS_FRAMES);
+        OutputDebugStringW(buf);
+        m_gdiStatsCalls = 0;
+        m_gdiStatsFrames = 0;
     }
+#endif
 
     // Restore font
     if (oldFont != nullptr)
     {
         SelectObject(dc, oldFont);
     }
+
+    m_drawnKey = MakeRenderKey(frame);
+
+    // Draw time, and how often the line bitmaps had to be re-rendered
+    int64_t drawUs = PlaybackClock::NowUs() - drawStartUs;
+    m_drawTimeTotalUs += drawUs;
+    m_drawTimeMaxUs = (std::max)(m_drawTimeMaxUs, drawUs);
+    if (++m_drawFrames == DRAW_STATS_FRAMES)
+    {
+        wchar_t buf[160];
+        swprintf_s(buf, L"[SPlayerLyric] Draw: %.0f us average, %lld us max, line bitmap rebuilds: %llu\n",
+            (double)m_drawTimeTotalUs / DRAW_STATS_FRAMES, m_drawTimeMaxUs, m_lineBitmap.Rebuilds());
+        OutputDebugStringW(buf);
+        m_drawTimeTotalUs = 0;
+        m_drawTimeMaxUs = 0;
+        m_drawFrames = 0;
+    }
 }
 
-void LyricDisplayItem::DrawDualLine(HDC dc, int x, int y, int w, int h, bool dark_mode)
+void LyricDisplayItem::DrawDualLine(HDC dc, const LyricManager::Frame& frame, int x, int y, int w, int h, bool dark_mode)
 {
     const auto& config = g_config.Data();
     
-    // Create font for dual line mode (uses dualLineFontSize instead of fontSize)
-    int dpi = GetDeviceCaps(dc, LOGPIXELSY);
-    int fontHeight = -MulDiv(config.dualLineFontSize, dpi, 72);
-    HFONT dualFont = CreateFontW(
-        fontHeight, 0, 0, 0,
-        config.fontWeightBold ? FW_BOLD : FW_NORMAL,
-        FALSE, FALSE, FALSE,
-        DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-        CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE,
-        config.fontName.c_str()
-    );
+    // Dual line mode uses dualLineFontSize instead of fontSize
+    HFONT dualFont = AcquireFont(m_dualFont, dc, config.dualLineFontSize);
     HFONT oldFont = (HFONT)SelectObject(dc, dualFont);
+    uint64_t dualFontId = m_dualFont.id;
     
     // Get current and second line text
-    std::wstring line1 = g_lyricMgr.GetCurrentLyricText();
-    std::wstring line2;
+    std::wstring_view line1 = frame.CurrentLineText();
+    std::wstring_view line2;
     
     if (config.secondLineType == 0)
     {
         // Next line
-        line2 = g_lyricMgr.GetNextLyricText();
+        line2 = frame.NextLineText();
     }
     else if (config.secondLineType == 1)
     {
         // Translation
-        line2 = g_lyricMgr.GetCurrentTranslation();
+        line2 = frame.CurrentTranslation();
     }
     else
     {
         // Artist/Song info
-        line2 = g_lyricMgr.GetSongInfoText();
+        line2 = frame.SongInfoText();
     }
     
     // If no current lyric, show song info or default
@@ -299,11 +604,11 @@ void LyricDisplayItem::DrawDualLine(HDC dc, int x, int y, int w, int h, bool dar
         }
         else
         {
-            line1 = g_lyricMgr.GetSongInfoText();
+            line1 = frame.SongInfoText();
             if (line1.empty())
                 line1 = g_config.StringRes(IDS_NO_LYRIC);
         }
-        line2.clear();
+        line2 = std::wstring_view();
     }
     
     // If second line is empty, and we are not in "Artist" mode, check if we should show single line
@@ -314,24 +619,22 @@ void LyricDisplayItem::DrawDualLine(HDC dc, int x, int y, int w, int h, bool dar
         // The user said "single line display", usually implying the standard single line look.
         
         SelectObject(dc, oldFont);
-        DeleteObject(dualFont);
         
-        DrawSimpleText(dc, x, y, w, h, dark_mode);
+        DrawSimpleText(dc, frame, x, y, w, h, dark_mode);
         return;
     }
     
     // Fallback to song info if second line is still empty (e.g., in Artist mode but info empty)
     if (line2.empty())
     {
-        line2 = g_lyricMgr.GetSongInfoText();
+        line2 = frame.SongInfoText();
     }
 
     // Double check if we still have only one line after fallback
     if (line2.empty())
     {
         SelectObject(dc, oldFont);
-        DeleteObject(dualFont);
-        DrawSimpleText(dc, x, y, w, h, dark_mode);
+        DrawSimpleText(dc, frame, x, y, w, h, dark_mode);
         return;
     }
     
@@ -384,7 +687,7 @@ void LyricDisplayItem::DrawDualLine(HDC dc, int x, int y, int w, int h, bool dar
     }
     
     // Dim if not playing
-    if (!g_wsClient.IsConnected() || !g_lyricMgr.IsPlaying())
+    if (!g_wsClient.IsConnected() || !frame.playback.isPlaying)
     {
         if (dark_mode)
         {
@@ -400,22 +703,15 @@ void LyricDisplayItem::DrawDualLine(HDC dc, int x, int y, int w, int h, bool dar
     
     // Draw first line (current lyric) - use top half
     // If YRC is enabled, use word-by-word discrete highlight for the first line
-    auto words = g_lyricMgr.GetCurrentYrcWords();
-    if (config.enableYrc && !words.empty() && g_wsClient.IsConnected() && g_lyricMgr.IsPlaying())
+    LyricTimeline::LineWords words = frame.CurrentYrcWords();
+    if (config.enableYrc && !words.empty() && g_wsClient.IsConnected() && frame.playback.isPlaying)
     {
-        int64_t currentTime = g_lyricMgr.GetCurrentTime();
         // Use the highlightColor determined by adaptive logic above, do NOT re-read from config
         
-        // Calculate total width of YRC words
-        int totalWidth = 0;
-        std::vector<SIZE> wordSizes;
-        for (const auto& word : words)
-        {
-            SIZE sz;
-            GetTextExtentPoint32W(dc, word.text.c_str(), (int)word.text.length(), &sz);
-            wordSizes.push_back(sz);
-            totalWidth += sz.cx;
-        }
+        // Word widths in the dual-line font, measured once per line
+        GdiTextMeasurer measurer(dc, dualFontId);
+        const LineLayout& layout = m_dualLayouts.Get(*frame.timeline, frame.lyrics->version, frame.lineIndex, measurer);
+        int totalWidth = layout.totalWidth;
 
         // Calculate alignment X
         int textX1 = x + 5; // Default Left
@@ -436,60 +732,16 @@ void LyricDisplayItem::DrawDualLine(HDC dc, int x, int y, int w, int h, bool dar
             textX1 = x + 5 - (int)m_scrollOffset;
         }
 
-        int textY1 = y + (lineHeight - (wordSizes.empty() ? 0 : wordSizes[0].cy)) / 2;
-
-        // Clip region for first line
-        HRGN clipRgn1 = CreateRectRgn(x, y, x + w, y + lineHeight + 2);
-        SelectClipRgn(dc, clipRgn1);
-
-        int curX = textX1;
-        for (size_t i = 0; i < words.size(); ++i)
-        {
-            const auto& word = words[i];
-            int width = wordSizes[i].cx;
-
-            // 1. Draw Normal Text (Background)
-            SetTextColor(dc, primaryColor);
-            TextOutW(dc, curX, textY1, word.text.c_str(), (int)word.text.length());
-
-            // 2. Draw Highlight Text (Foreground with clip)
-            long long endTime = word.startTime + word.duration;
-            double progress = 0.0;
-            
-            if (currentTime >= endTime) 
-                progress = 1.0;
-            else if (currentTime >= word.startTime && word.duration > 0)
-                progress = (double)(currentTime - word.startTime) / word.duration;
+        int textY1 = y + (lineHeight - layout.height) / 2;
 
-            if (progress > 0.001)
-            {
-                int effectiveWidth = (int)(width * progress);
-                if (effectiveWidth > 0)
-                {
-                    int saveId = SaveDC(dc);
-                    HRGN wordClip = CreateRectRgn(curX, y, curX + effectiveWidth, y + lineHeight + 2);
-                    ExtSelectClipRgn(dc, wordClip, RGN_AND);
-                    
-                    SetTextColor(dc, highlightColor);
-                    TextOutW(dc, curX, textY1, word.text.c_str(), (int)word.text.length());
-                    
-                    RestoreDC(dc, saveId);
-                    DeleteObject(wordClip);
-                }
-            }
-
-            curX += width;
-        }
-        
-        SelectClipRgn(dc, NULL);
-        DeleteObject(clipRgn1);
+        RECT clip1 = { x, y, x + w, y + lineHeight + 2 };
+        DrawHighlightedWords(frame, layout, textX1, textY1, clip1, primaryColor, highlightColor);
     }
     else
     {
         // Simple text for first line
-        SetTextColor(dc, primaryColor);
-        SIZE size1;
-        GetTextExtentPoint32W(dc, line1.c_str(), (int)line1.length(), &size1);
+        m_painter.SetColor(primaryColor);
+        TextExtent size1 = MeasureText(dc, dualFontId, line1);
         
         int textY1 = y + (lineHeight - size1.cy) / 2;
         int textX1 = x + 5; // Default Left
@@ -510,17 +762,13 @@ void LyricDisplayItem::DrawDualLine(HDC dc, int x, int y, int w, int h, bool dar
             textX1 = x + 5 - (int)m_scrollOffset;
         }
         
-        HRGN clipRgn1 = CreateRectRgn(x, y, x + w, y + lineHeight + 2);
-        SelectClipRgn(dc, clipRgn1);
-        TextOutW(dc, textX1, textY1, line1.c_str(), (int)line1.length());
-        SelectClipRgn(dc, NULL);
-        DeleteObject(clipRgn1);
+        RECT clip1 = { x, y, x + w, y + lineHeight + 2 };
+        m_painter.Draw(textX1, textY1, line1, &clip1);
     }
     
     // Draw second line
-    SetTextColor(dc, secondaryColor);
-    SIZE size2;
-    GetTextExtentPoint32W(dc, line2.c_str(), (int)line2.length(), &size2);
+    m_painter.SetColor(secondaryColor);
+    TextExtent size2 = MeasureText(dc, dualFontId, line2);
     
     int textY2 = y + lineHeight + (lineHeight - size2.cy) / 2;
     int textX2 = x + 5;
@@ -539,20 +787,16 @@ void LyricDisplayItem::DrawDualLine(HDC dc, int x, int y, int w, int h, bool dar
     // Scrolling for second line (independent or just static?) - keep it static for now as per design
     
     // Clip for second line - allow a bit room at top for ascenders
-    HRGN clipRgn2 = CreateRectRgn(x, y + lineHeight - 1, x + w, y + h);
-    SelectClipRgn(dc, clipRgn2);
-    TextOutW(dc, textX2, textY2, line2.c_str(), (int)line2.length());
-    SelectClipRgn(dc, NULL);
-    DeleteObject(clipRgn2);
+    RECT clip2 = { x, y + lineHeight - 1, x + w, y + h };
+    m_painter.Draw(textX2, textY2, line2, &clip2);
     
-    // Restore original font and cleanup
+    // Restore original font; the dual-line font stays cached
     SelectObject(dc, oldFont);
-    DeleteObject(dualFont);
 }
 
-void LyricDisplayItem::DrawSimpleText(HDC dc, int x, int y, int w, int h, bool dark_mode)
+void LyricDisplayItem::DrawSimpleText(HDC dc, const LyricManager::Frame& frame, int x, int y, int w, int h, bool dark_mode)
 {
-    std::wstring text = GetDisplayText();
+    std::wstring_view text = GetDisplayText(frame);
     if (text.empty())
         return;
 
@@ -568,7 +812,7 @@ void LyricDisplayItem::DrawSimpleText(HDC dc, int x, int y, int w, int h, bool d
         textColor = g_config.Data().lightNormalColor;
 
     // Dim if not playing
-    if (!g_wsClient.IsConnected() || !g_lyricMgr.IsPlaying())
+    if (!g_wsClient.IsConnected() || !frame.playback.isPlaying)
     {
         if (dark_mode)
             textColor = RGB(150, 150, 150);
@@ -576,11 +820,10 @@ void LyricDisplayItem::DrawSimpleText(HDC dc, int x, int y, int w, int h, bool d
             textColor = RGB(100, 100, 100);
     }
 
-    SetTextColor(dc, textColor);
+    m_painter.SetColor(textColor);
 
     // Calculate text size
-    SIZE textSize;
-    GetTextExtentPoint32W(dc, text.c_str(), (int)text.length(), &textSize);
+    TextExtent textSize = MeasureText(dc, m_font.id, text);
 
     // Update scroll animation
     UpdateScrollAnimation(textSize.cx, w);
@@ -589,69 +832,53 @@ void LyricDisplayItem::DrawSimpleText(HDC dc, int x, int y, int w, int h, bool d
 
     if (textSize.cx > w && g_config.Data().enableScrolling)
     {
-        // Create clipping region
-        HRGN clipRgn = CreateRectRgn(x, y, x + w, y + h);
-        SelectClipRgn(dc, clipRgn);
-
+        RECT clip = { x, y, x + w, y + h };
         int textX = x - (int)m_scrollOffset + g_config.Data().desktopXOffset; // Apply offset
-        TextOutW(dc, textX, textY, text.c_str(), (int)text.length());
-
-        SelectClipRgn(dc, NULL);
-        DeleteObject(clipRgn);
+        m_painter.Draw(textX, textY, text, &clip);
     }
     else if (textSize.cx > w)
     {
         // Ellipsis mode
         RECT drawRect = { x, textY, x + w, textY + textSize.cy };
-        DrawTextW(dc, text.c_str(), (int)text.length(), &drawRect,
-            DT_LEFT | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+        m_painter.DrawEllipsis(drawRect, text);
     }
     else
     {
         // Center
         int textX = x + (w - textSize.cx) / 2;
         textX += g_config.Data().desktopXOffset; // Apply offset
-        TextOutW(dc, textX, textY, text.c_str(), (int)text.length());
+        m_painter.Draw(textX, textY, text);
     }
 }
 
-void LyricDisplayItem::DrawWithYrcHighlight(HDC dc, int x, int y, int w, int h, bool dark_mode)
+void LyricDisplayItem::DrawWithYrcHighlight(HDC dc, const LyricManager::Frame& frame, int x, int y, int w, int h, bool dark_mode)
 {
-    auto words = g_lyricMgr.GetCurrentYrcWords();
-    int currentLineIdx = g_lyricMgr.GetCurrentLineIndex();
+    LyricTimeline::LineWords words = frame.CurrentYrcWords();
+    int currentLineIdx = frame.lineIndex;
 
-    // Check for line change to trigger transition
-    if (currentLineIdx != m_lastLineIndex)
+    // Check for line change to trigger transition. The text shown so far
+    // becomes the previous line; copied only here, not every frame.
+    if (currentLineIdx != m_lastLineIndex || frame.lyrics->version != m_lastLyricsVersion)
     {
         if (m_lastLineIndex != -1) // Don't animate first load
         {
             m_transitionStartTime = GetTickCount64();
             m_inTransition = true;
-            m_prevLineText = GetDisplayText(); // Use full text for prev line
-            // Wait, GetDisplayText() returns CURRENT text. We need previous text.
-            // But m_lastLineIndex is old, LyricManager already has new data.
-            // We should have stored previous text before update? No, LyricManager updates async.
-            // We can't query old text easily from LyricManager unless we cache it.
-            // However, m_prevLineText should be updated AFTER drawing, or assume we missed it?
-            // Actually, best way: Store m_currentText in class, update it at end of frame.
-            // But let's cheat: we can't easily get old YRC words, so for "Previous Line", 
-            // we will just draw it as simple text (m_prevLineText).
         }
+        m_prevLineText.swap(m_currentLineText);
+        m_currentLineText.assign(GetDisplayText(frame));
         m_lastLineIndex = currentLineIdx;
+        m_lastLyricsVersion = frame.lyrics->version;
     }
 
     if (words.empty())
     {
         // If we are transitioning FROM valid words to empty, we should still animate?
         // For simplicity, falls back to SimpleText if empty
-        DrawSimpleText(dc, x, y, w, h, dark_mode);
-        
-        // Update valid cache
-        m_prevLineText = GetDisplayText();
+        DrawSimpleText(dc, frame, x, y, w, h, dark_mode);
         return;
     }
 
-    int64_t currentTime = g_lyricMgr.GetCurrentTime();
     const auto& config = g_config.Data();
 
     // Set colors based on dark mode
@@ -672,7 +899,7 @@ void LyricDisplayItem::DrawWithYrcHighlight(HDC dc, int x, int y, int w, int h,
     }
 
     // Dim if not playing
-    if (!g_wsClient.IsConnected() || !g_lyricMgr.IsPlaying())
+    if (!g_wsClient.IsConnected() || !frame.playback.isPlaying)
     {
         if (dark_mode)
         {
@@ -686,21 +913,15 @@ void LyricDisplayItem::DrawWithYrcHighlight(HDC dc, int x, int y, int w, int h,
         }
     }
 
-    // First pass: calculate total width
-    int totalWidth = 0;
-    std::vector<SIZE> wordSizes;
-    for (const auto& word : words)
-    {
-        SIZE size;
-        GetTextExtentPoint32W(dc, word.text.c_str(), (int)word.text.length(), &size);
-        wordSizes.push_back(size);
-        totalWidth += size.cx;
-    }
+    // Word widths: normally prefetched by the timer before the line started
+    GdiTextMeasurer measurer(dc, m_font.id);
+    const LineLayout& layout = m_layouts.Get(*frame.timeline, frame.lyrics->version, frame.lineIndex, measurer);
+    int totalWidth = layout.totalWidth;
 
     // Update scroll
     UpdateScrollAnimation(totalWidth, w);
 
-    int textY = y + (h - (wordSizes.empty() ? 0 : wordSizes[0].cy)) / 2;
+    int textY = y + (h - layout.height) / 2;
     
     // Calculate starting X position
     // Calculate starting X position based on alignment
@@ -730,13 +951,8 @@ void LyricDisplayItem::DrawWithYrcHighlight(HDC dc, int x, int y, int w, int h,
     // Apply global offset
     startX += config.desktopXOffset;
 
-    // Create clipping region if needed
-    HRGN clipRgn = nullptr;
-    if (totalWidth > w)
-    {
-        clipRgn = CreateRectRgn(x, y, x + w, y + h);
-        SelectClipRgn(dc, clipRgn);
-    }
+    // Everything below is clipped to the item
+    RECT clip = { x, y, x + w, y + h };
 
     // Draw each word
     // Draw Transition (Scroll Up)
@@ -769,8 +985,7 @@ void LyricDisplayItem::DrawWithYrcHighlight(HDC dc, int x, int y, int w, int h,
                  // We need custom drawing for prev line to ensure position matches.
                  // Let's reuse basic TextOut logic for prev line.
                  
-                 SIZE prevSize;
-                 GetTextExtentPoint32W(dc, m_prevLineText.c_str(), (int)m_prevLineText.length(), &prevSize);
+                 TextExtent prevSize = MeasureText(dc, m_font.id, m_prevLineText);
                  
                  // Align prev line same as current (approx)
                  int prevX = startX; // This might jump if alignment changes, but usually consistent
@@ -780,19 +995,14 @@ void LyricDisplayItem::DrawWithYrcHighlight(HDC dc, int x, int y, int w, int h,
                  // Center vertically in the OFFSET position
                  int prevTextY = prevY + (h - prevSize.cy) / 2;
                  
-                 SetTextColor(dc, normalColor); // Old line is normal color
-                 
-                 HRGN prevClip = CreateRectRgn(x, y, x + w, y + h);
-                 SelectClipRgn(dc, prevClip);
-                 TextOutW(dc, prevX, prevTextY, m_prevLineText.c_str(), (int)m_prevLineText.length());
-                 SelectClipRgn(dc, NULL);
-                 DeleteObject(prevClip);
+                 m_painter.SetColor(normalColor); // Old line is normal color
+                 m_painter.Draw(prevX, prevTextY, m_prevLineText, &clip);
             }
             
             // Draw Current Line (moving up: y + h -> y)
             // We modify 'y' and 'textY' for the main drawing loop below
             // Original textY calculation:
-            // int textY = y + (h - (wordSizes.empty() ? 0 : wordSizes[0].cy)) / 2;
+            // int textY = y + (h - layout.height) / 2;
             
             // We want it to start at y+h and move to y
             // So offset is (1 - progress) * h? No.
@@ -804,66 +1014,9 @@ void LyricDisplayItem::DrawWithYrcHighlight(HDC dc, int x, int y, int w, int h,
         }
     }
 
-    if (clipRgn)
-    {
-        // Re-select clip region if we messed with it (we did)
-        SelectClipRgn(dc, clipRgn);
-    }
-    
-    // Draw each word with smooth highlight
-    int currentX = startX;
-    for (size_t i = 0; i < words.size(); i++)
-    {
-        const auto& word = words[i];
-        const auto& size = wordSizes[i];
-
-        // 1. Draw Background (Normal Color)
-        SetTextColor(dc, normalColor);
-        TextOutW(dc, currentX, textY, word.text.c_str(), (int)word.text.length());
-
-        // 2. Calculate Progress
-        double progress = 0.0;
-        long long endTime = word.startTime + word.duration;
-        
-        if (currentTime >= endTime)
-            progress = 1.0;
-        else if (currentTime >= word.startTime && word.duration > 0)
-            progress = (double)(currentTime - word.startTime) / word.duration;
-
-        // 3. Draw Foreground (Highlight Color) with Clip
-        if (progress > 0.001)
-        {
-            int fillWidth = (int)(size.cx * progress);
-            if (fillWidth > 0)
-            {
-                int saveId = SaveDC(dc);
-                
-                // Clip rect: currentX to currentX + fillWidth
-                // Must intersect with existing clip if scrolling
-                HRGN wordClip = CreateRectRgn(currentX, y, currentX + fillWidth, y + h);
-                ExtSelectClipRgn(dc, wordClip, RGN_AND);
-                
-                SetTextColor(dc, highlightColor);
-                TextOutW(dc, currentX, textY, word.text.c_str(), (int)word.text.length());
-                
-                RestoreDC(dc, saveId);
-                DeleteObject(wordClip);
-            }
-        }
-
-        currentX += size.cx;
-    }
-
-    if (clipRgn)
-    {
-        SelectClipRgn(dc, NULL);
-        DeleteObject(clipRgn);
-    }
-    
-    // Update cache for next frame detection
-    // Note: this is slightly wrong because "GetDisplayText()" might not match "words" if race condition
-    // But close enough for visual transition
-    m_prevLineText = GetDisplayText();
+    // The transition moves the line vertically; draw it word by word until it settles
+    if (m_inTransition || !DrawLineBitmap(dc, frame, layout, startX, textY, clip, dark_mode, normalColor, highlightColor))
+        DrawHighlightedWords(frame, layout, startX, textY, clip, normalColor, highlightColor);
 }
 
 int LyricDisplayItem::OnMouseEvent(MouseEventType type, int x, int y, void* hWnd, int flag)
@@ -904,23 +1057,79 @@ void CALLBACK LyricDisplayItem::HighFreqTimerProc(HWND hwnd, UINT uMsg, UINT_PTR
 {
     if (g_pLyricItem && g_pLyricItem->m_highFreqEnabled && g_pLyricItem->m_taskbarWnd)
     {
-        // Only refresh when YRC is enabled and playing
-        if (g_config.Data().enableYrc && g_lyricMgr.IsPlaying() && g_lyricMgr.HasYrcData())
+        g_pLyricItem->OnRefreshTick();
+    }
+}
+
+// Repaints the item if needed, then re-arms the timer for the next moment
+// the picture can change. Outside YRC playback it only polls slowly.
+void LyricDisplayItem::OnRefreshTick()
+{
+    RefreshScheduler::Input input;
+
+    // Only refresh when YRC is enabled and playing
+    if (g_config.Data().enableYrc && g_lyricMgr.IsPlaying() && g_lyricMgr.HasYrcData())
+    {
+        LyricManager::Frame frame = g_lyricMgr.GetFrame();
+
+        // Measure the upcoming line now rather than in the paint that shows it
+        PrefetchLayout(frame);
+
+        // Invalidate only the lyric item, and only if the frame would change;
+        // TrafficMonitor will call DrawItem when processing WM_PAINT
+        if (NeedsRepaint(frame))
         {
-            // Invalidate the entire taskbar window to trigger redraw
-            // TrafficMonitor will call DrawItem when processing WM_PAINT
-            InvalidateRect(g_pLyricItem->m_taskbarWnd, NULL, FALSE);
+            InvalidateRect(m_taskbarWnd, IsRectEmpty(&m_itemRect) ? NULL : &m_itemRect, FALSE);
         }
+
+        input = MakeRefreshInput(frame);
+        input.yrcPlaying = true;
+    }
+    int interval = RefreshScheduler::NextInterval(input);
+
+    // Same id: replaces the pending timer, so it acts as a one-shot deadline
+    m_highFreqTimerId = SetTimer(NULL, m_highFreqTimerId, interval, HighFreqTimerProc);
+
+    if (m_wakeups.Record((int64_t)GetTickCount64()))
+    {
+        wchar_t buf[128];
+        swprintf_s(buf, L"[SPlayerLyric] Refresh wakeups: %.1f/s average, %d/s p99\n",
+            m_wakeups.Average(), m_wakeups.P99());
+        OutputDebugStringW(buf);
     }
 }
 
+// Runs on the timer tick, outside WM_PAINT. Measures the next YRC line with
+// the font of the active mode on a private memory DC shortly before it starts.
+void LyricDisplayItem::PrefetchLayout(const LyricManager::Frame& frame)
+{
+    bool dualLine = g_config.Data().desktopDualLine;
+    const CachedFont& font = dualLine ? m_dualFont : m_font;
+    LineLayoutCache& layouts = dualLine ? m_dualLayouts : m_layouts;
+    if (font.handle == nullptr)
+        return;
+
+    if (frame.timeline != &frame.lyrics->data.yrcData)
+        return;
+
+    if (m_measureDc == nullptr)
+        m_measureDc = CreateCompatibleDC(NULL);
+    if (m_measureDc == nullptr)
+        return;
+
+    HFONT oldFont = (HFONT)SelectObject(m_measureDc, font.handle);
+    GdiTextMeasurer measurer(m_measureDc, font.id);
+    layouts.Prefetch(*frame.timeline, frame.lyrics->version, frame.lineIndex, frame.currentTime, measurer);
+    SelectObject(m_measureDc, oldFont);
+}
+
 void LyricDisplayItem::StartHighFreqRefresh()
 {
     if (m_highFreqTimerId == 0)
     {
-        // Create timer with ~100ms interval (10 FPS boost)
-        // Using NULL for hwnd makes it a thread timer
-        m_highFreqTimerId = SetTimer(NULL, 0, 16, HighFreqTimerProc);
+        // Using NULL for hwnd makes it a thread timer; each tick re-arms it
+        // for the deadline RefreshScheduler picks
+        m_highFreqTimerId = SetTimer(NULL, 0, RefreshScheduler::MIN_INTERVAL_MS, HighFreqTimerProc);
         m_highFreqEnabled = true;
         OutputDebugStringW(L"[SPlayerLyric] High-frequency refresh started\n");
     }
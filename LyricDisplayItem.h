@@ -7,6 +7,12 @@
 #pragma once
 
 #include "PluginInterface.h"
+#include "LyricManager.h"
+#include "LineLayout.h"
+#include "TextMeasureCache.h"
+#include "TextPainter.h"
+#include "RefreshScheduler.h"
+#include "LineBitmap.h"
 #include <string>
 #include <atomic>
 
@@ -34,37 +40,134 @@ public:
     void StopHighFreqRefresh();
 
 private:
-    std::wstring GetDisplayText() const;
+    // A GDI font kept across frames, recreated only when its parameters change
+    struct CachedFont
+    {
+        HFONT handle = nullptr;
+        int size = 0;
+        std::wstring name;
+        bool bold = false;
+        int dpi = 0;
+        uint64_t id = 0;    // MakeFontId of the parameters, keys the measure caches
+    };
+
+    // What a frame shows, as far as the high-frequency refresh can change it
+    struct RenderKey
+    {
+        uint64_t lyricsVersion = 0;
+        uint64_t songVersion = 0;   // Song info is shown before the first line
+        int lineIndex = -1;
+        bool isPlaying = false;
+        bool isConnected = false;
+        size_t completedWords = 0;
+        int activeWord = -1;
+        int fillWidth = 0;      // Sung pixels of the active word, -1 if not laid out
+
+        bool operator==(const RenderKey& other) const
+        {
+            return lyricsVersion == other.lyricsVersion && songVersion == other.songVersion &&
+                lineIndex == other.lineIndex && isPlaying == other.isPlaying &&
+                isConnected == other.isConnected && completedWords == other.completedWords &&
+                activeWord == other.activeWord && fillWidth == other.fillWidth;
+        }
+    };
+
+    std::wstring_view GetDisplayText(const LyricManager::Frame& frame) const;
+    RenderKey MakeRenderKey(const LyricManager::Frame& frame) const;
+    bool NeedsRepaint(const LyricManager::Frame& frame) const;
+    const LineLayout* PeekLayout(const LyricManager::Frame& frame) const;
+    int64_t AnimationIntervalMs() const;
+    RefreshScheduler::Input MakeRefreshInput(const LyricManager::Frame& frame) const;
     HFONT GetFont(HDC hDC) const;
+    HFONT AcquireFont(CachedFont& font, HDC hDC, int pointSize) const;
+    static void ReleaseFont(CachedFont& font);
+    static DWORD GdiObjectCount();
     
-    void DrawSimpleText(HDC dc, int x, int y, int w, int h, bool dark_mode);
-    void DrawDualLine(HDC dc, int x, int y, int w, int h, bool dark_mode);
-    void DrawWithYrcHighlight(HDC dc, int x, int y, int w, int h, bool dark_mode);
+    void DrawSimpleText(HDC dc, const LyricManager::Frame& frame, int x, int y, int w, int h, bool dark_mode);
+    void DrawDualLine(HDC dc, const LyricManager::Frame& frame, int x, int y, int w, int h, bool dark_mode);
+    void DrawWithYrcHighlight(HDC dc, const LyricManager::Frame& frame, int x, int y, int w, int h, bool dark_mode);
+    void DrawHighlightedWords(const LyricManager::Frame& frame, const LineLayout& layout,
+        int startX, int textY, const RECT& clip, COLORREF normalColor, COLORREF highlightColor);
+    bool DrawLineBitmap(HDC dc, const LyricManager::Frame& frame, const LineLayout& layout,
+        int startX, int textY, const RECT& clip, bool darkMode, COLORREF normalColor, COLORREF highlightColor);
     void UpdateScrollAnimation(int textWidth, int areaWidth);
+    TextExtent MeasureText(HDC dc, uint64_t fontId, std::wstring_view text);
+    void PrefetchLayout(const LyricManager::Frame& frame);
+    void OnRefreshTick();
     
     static void CALLBACK HighFreqTimerProc(HWND hwnd, UINT uMsg, UINT_PTR idEvent, DWORD dwTime);
 
-    mutable HFONT m_font = nullptr;
-    mutable int m_lastFontSize = 0;
-    mutable std::wstring m_lastFontName;
-    mutable bool m_lastFontBold = false;
+    mutable CachedFont m_font;          // fontSize, single-line modes
+    mutable CachedFont m_dualFont;      // dualLineFontSize
+
+    // YRC word layout, the next line measured ahead from the timer tick
+    LineLayoutCache m_layouts;
+    LineLayoutCache m_dualLayouts;
+    HDC m_measureDc = nullptr;
+
+    // Current YRC line pre-rendered in both colors
+    LineBitmapCache m_lineBitmap;
+
+    // Whether the background under the YRC line is flat, sampled once per
+    // line, theme (TrafficMonitor's dark mode and the colors) and clip
+    // rectangle rather than every frame
+    struct BackgroundSample
+    {
+        uint64_t lyricsVersion = 0;
+        int lineIndex = -1;
+        bool darkMode = false;
+        COLORREF normalColor = 0;
+        COLORREF highlightColor = 0;
+        RECT clip = {};
+        COLORREF color = CLR_INVALID;   // CLR_INVALID when not flat
+
+        bool Matches(uint64_t version, int line, bool dark, COLORREF normal, COLORREF highlight, const RECT& rect) const
+        {
+            return lyricsVersion == version && lineIndex == line && darkMode == dark &&
+                normalColor == normal && highlightColor == highlight && EqualRect(&clip, &rect);
+        }
+    };
+    BackgroundSample m_background;
+
+    // Draw time statistics, logged every DRAW_STATS_FRAMES frames
+    static const int DRAW_STATS_FRAMES = 600;
+    int64_t m_drawTimeTotalUs = 0;
+    int64_t m_drawTimeMaxUs = 0;
+    int m_drawFrames = 0;
+
+    // Text output for the frame being drawn
+    TextPainter m_painter;
+#ifdef SPLAYERLYRIC_GDI_STATS
+    static const int GDI_STATS_FRAMES = 120;
+    uint64_t m_gdiStatsCalls = 0;
+    int m_gdiStatsFrames = 0;
+#endif
+
+    // Whole-string extents; cleared when new lyrics arrive
+    TextMeasureCache m_textCache;
+    uint64_t m_measureVersion = 0;
 
     // Scroll animation state (time-based)
     mutable float m_scrollOffset = 0.0f;
     mutable ULONGLONG m_scrollStartTime = 0;
     mutable ULONGLONG m_scrollCycleLength = 0;
+    mutable ULONGLONG m_scrollStillUntil = 0;  // End of the current pause at a scroll end, 0 while moving
 
     // High-frequency refresh for smooth YRC
     mutable HWND m_taskbarWnd = nullptr;
-    mutable RECT m_itemRect = {0};
+    mutable RECT m_itemRect = {0};             // Where DrawItem last drew, in taskbar window coordinates
+    RenderKey m_drawnKey;                       // What it drew there
     mutable UINT_PTR m_highFreqTimerId = 0;
     mutable std::atomic<bool> m_highFreqEnabled{false};
+    WakeupStats m_wakeups;
     
     mutable std::wstring m_itemName;
 
     // Transition state
     mutable int m_lastLineIndex = -1;
+    mutable uint64_t m_lastLyricsVersion = 0;
     mutable ULONGLONG m_transitionStartTime = 0;
     mutable std::wstring m_prevLineText;
+    mutable std::wstring m_currentLineText;    // Becomes m_prevLineText on the next line change
     mutable bool m_inTransition = false;
 };
@@ -5,10 +5,10 @@
  */
 
 #include "pch.h"
-#include <afxwin.h>
 #include "LyricManager.h"
-#include "Config.h"
 #include <algorithm>
+#include <cstring>
+#include <type_traits>
 
 LyricManager& LyricManager::Instance()
 {
@@ -16,237 +16,212 @@ LyricManager& LyricManager::Instance()
     return instance;
 }
 
-void LyricManager::UpdateLyrics(const SPlayerProtocol::LyricData& data)
-{
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_lyricData = data;
-    m_currentLineIndex = -1;
-
-    // Debug
-    wchar_t buf[256];
-    swprintf_s(buf, L"[SPlayerLyric] UpdateLyrics: LRC=%zu, YRC=%zu\n", 
-        data.lrcData.size(), data.yrcData.size());
-    OutputDebugStringW(buf);
-}
+static_assert(std::is_trivially_copyable<LyricManager::PlaybackState>::value,
+    "PlaybackState is copied through the seqlock as raw words");
 
-void LyricManager::UpdateProgress(int64_t currentTime)
+LyricManager::LyricManager()
+    : m_lyrics(std::make_shared<LyricSnapshot>())
+    , m_songInfo(std::make_shared<SongSnapshot>())
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_currentTime = currentTime; // Base time from SPlayer
-    m_lastUpdateTick = GetTickCount64();
-    m_currentLineIndex = FindCurrentLine(GetTimeWithOffset()); // Use helper for indexing
+    WritePlayback(PlaybackState());
 }
 
-int64_t LyricManager::GetTimeWithOffset() const
+void LyricManager::SetOptions(const Options& options)
 {
-    return m_currentTime + g_config.Data().lyricOffset;
+    m_enableYrc.store(options.enableYrc, std::memory_order_relaxed);
+    m_lyricOffset.store(options.lyricOffset, std::memory_order_relaxed);
 }
 
-void LyricManager::UpdateSongInfo(const SPlayerProtocol::SongInfo& info)
+LyricManager::PlaybackState LyricManager::ReadPlayback() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_songInfo = info;
+    uint64_t words[PLAYBACK_WORDS];
+    uint32_t seq;
+    do
+    {
+        seq = m_playbackSeq.load(std::memory_order_acquire);
+        for (size_t i = 0; i < PLAYBACK_WORDS; ++i)
+            words[i] = m_playback[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) != 0 || seq != m_playbackSeq.load(std::memory_order_relaxed));
+
+    PlaybackState state;
+    memcpy(&state, words, sizeof(state));
+    return state;
 }
 
-void LyricManager::UpdatePlayStatus(bool isPlaying)
+// Caller holds m_writeMutex (or is the constructor)
+void LyricManager::WritePlayback(const PlaybackState& state)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_isPlaying = isPlaying;
+    uint64_t words[PLAYBACK_WORDS] = {};
+    memcpy(words, &state, sizeof(state));
+
+    uint32_t seq = m_playbackSeq.load(std::memory_order_relaxed);
+    m_playbackSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < PLAYBACK_WORDS; ++i)
+        m_playback[i].store(words[i], std::memory_order_relaxed);
+
+    m_playbackSeq.store(seq + 2, std::memory_order_release);
 }
 
-void LyricManager::Clear()
+LyricManager::Frame LyricManager::GetFrame() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_lyricData = SPlayerProtocol::LyricData();
-    m_songInfo = SPlayerProtocol::SongInfo();
-    m_currentTime = 0;
-    m_currentLineIndex = -1;
-    m_isPlaying = false;
+    Frame frame;
+    frame.lyrics = LoadLyrics();
+    frame.song = std::atomic_load(&m_songInfo);
+    frame.playback = ReadPlayback();
+    frame.currentTime = (int64_t)frame.playback.clock.PositionAt(PlaybackClock::NowUs()) + m_lyricOffset.load(std::memory_order_relaxed);
+    frame.timeline = ActiveTimeline(frame.lyrics->data);
+
+    // An index computed for the previous song does not apply yet. Otherwise
+    // move on from the last reported line to wherever the clock is now.
+    if (frame.timeline && frame.playback.lyricsVersion == frame.lyrics->version)
+        frame.lineIndex = frame.timeline->FindLine(frame.currentTime, frame.playback.lineIndex);
+    frame.highlight = ComputeHighlight(frame);
+    return frame;
 }
 
-std::wstring LyricManager::GetCurrentLyricText() const
+LyricManager::Highlight LyricManager::ComputeHighlight(const Frame& frame) const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    Highlight highlight;
+    LyricTimeline::LineWords words = frame.CurrentYrcWords();
+    if (words.empty())
+        return highlight;
 
-    if (g_config.Data().enableYrc && m_lyricData.hasYrc())
-    {
-        if (m_currentLineIndex >= 0 && m_currentLineIndex < (int)m_lyricData.yrcData.size())
-        {
-            const auto& line = m_lyricData.yrcData[m_currentLineIndex];
-            std::wstring result;
-            for (const auto& word : line.words)
-            {
-                result += word.text;
-            }
-            return result;
-        }
-    }
-    else if (m_lyricData.hasLrc())
+    // Resume from the previous frame's cursor when it is for the same line
+    uint64_t cursor = m_wordCursor.load(std::memory_order_relaxed);
+    size_t hint = (uint32_t)(cursor >> 32) == (uint32_t)frame.lineIndex ? (uint32_t)cursor : 0;
+
+    highlight.completedWords = frame.timeline->CompletedWords(frame.lineIndex, frame.currentTime, hint);
+    m_wordCursor.store(((uint64_t)(uint32_t)frame.lineIndex << 32) | highlight.completedWords, std::memory_order_relaxed);
+
+    if (highlight.completedWords < words.size())
     {
-        if (m_currentLineIndex >= 0 && m_currentLineIndex < (int)m_lyricData.lrcData.size())
-        {
-            return m_lyricData.lrcData[m_currentLineIndex].text;
-        }
+        LyricTimeline::Word word = words[highlight.completedWords];
+        highlight.activeWord = (int)highlight.completedWords;
+        if (frame.currentTime > word.startTime && word.duration > 0)
+            highlight.activeProgress = (std::min)(1.0f, (float)(frame.currentTime - word.startTime) / (float)word.duration);
     }
+    return highlight;
+}
 
-    return std::wstring();
+void LyricManager::UpdateLyrics(SPlayerProtocol::LyricData&& data)
+{
+    // Take over the parsed timelines, then only the pointer swap happens
+    // under the lock. Readers keep using the old snapshot meanwhile.
+    auto snapshot = std::make_shared<LyricSnapshot>();
+    snapshot->data = std::move(data);
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    snapshot->version = ++m_lyricsVersion;
+    std::atomic_store(&m_lyrics, std::shared_ptr<const LyricSnapshot>(std::move(snapshot)));
 }
 
-std::wstring LyricManager::GetNextLyricText() const
+void LyricManager::UpdateProgress(int64_t currentTime)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    auto lyrics = LoadLyrics();
+    PlaybackState state = ReadPlayback();
 
-    int nextIndex = m_currentLineIndex + 1;
+    // The previous line index is the cursor for the next lookup
+    int hint = state.lyricsVersion == lyrics->version ? state.lineIndex : -1;
+    const LyricTimeline* timeline = ActiveTimeline(lyrics->data);
 
-    if (g_config.Data().enableYrc && m_lyricData.hasYrc())
-    {
-        if (nextIndex >= 0 && nextIndex < (int)m_lyricData.yrcData.size())
-        {
-            const auto& line = m_lyricData.yrcData[nextIndex];
-            std::wstring result;
-            for (const auto& word : line.words)
-            {
-                result += word.text;
-            }
-            return result;
-        }
-    }
-    else if (m_lyricData.hasLrc())
-    {
-        if (nextIndex >= 0 && nextIndex < (int)m_lyricData.lrcData.size())
-        {
-            return m_lyricData.lrcData[nextIndex].text;
-        }
-    }
+    m_clock.AddSample(currentTime, PlaybackClock::NowUs());
 
-    return std::wstring();
+    state.clock = m_clock.Current();
+    state.currentTime = currentTime; // Base time from SPlayer
+    state.lineIndex = timeline ? timeline->FindLine(currentTime + m_lyricOffset.load(std::memory_order_relaxed), hint) : -1;
+    state.lyricsVersion = lyrics->version;
+    WritePlayback(state);
 }
 
-std::wstring LyricManager::GetCurrentTranslation() const
+void LyricManager::UpdateSongInfo(const SPlayerProtocol::SongInfo& info)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    // Get translation from current line's translation field
-    if (g_config.Data().enableYrc && m_lyricData.hasYrc())
-    {
-        if (m_currentLineIndex >= 0 && m_currentLineIndex < (int)m_lyricData.yrcData.size())
-        {
-            return m_lyricData.yrcData[m_currentLineIndex].translation;
-        }
-    }
-    else if (m_lyricData.hasLrc())
-    {
-        if (m_currentLineIndex >= 0 && m_currentLineIndex < (int)m_lyricData.lrcData.size())
-        {
-            return m_lyricData.lrcData[m_currentLineIndex].translation;
-        }
-    }
+    auto song = std::make_shared<SongSnapshot>();
+    song->info = info;
+    if (!info.title.empty())
+        song->displayText = info.title;
+    else if (!info.name.empty() && !info.artist.empty())
+        song->displayText = info.name + L" - " + info.artist;
+    else
+        song->displayText = info.name;
 
-    return std::wstring();
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    song->version = ++m_songVersion;
+    std::atomic_store(&m_songInfo, std::shared_ptr<const SongSnapshot>(std::move(song)));
 }
 
-std::wstring LyricManager::GetSongInfoText() const
+void LyricManager::UpdatePlayStatus(bool isPlaying)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_clock.SetPlaying(isPlaying, PlaybackClock::NowUs());
 
-    if (!m_songInfo.title.empty())
-        return m_songInfo.title;
+    PlaybackState state = ReadPlayback();
+    state.clock = m_clock.Current();
+    state.isPlaying = isPlaying;
+    WritePlayback(state);
+}
 
-    if (!m_songInfo.name.empty())
-    {
-        if (!m_songInfo.artist.empty())
-            return m_songInfo.name + L" - " + m_songInfo.artist;
-        return m_songInfo.name;
-    }
+void LyricManager::Clear()
+{
+    auto lyrics = std::make_shared<LyricSnapshot>();
+    auto song = std::make_shared<SongSnapshot>();
 
-    return std::wstring();
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    lyrics->version = ++m_lyricsVersion;
+    song->version = ++m_songVersion;
+    std::atomic_store(&m_lyrics, std::shared_ptr<const LyricSnapshot>(std::move(lyrics)));
+    std::atomic_store(&m_songInfo, std::shared_ptr<const SongSnapshot>(std::move(song)));
+
+    m_clock.Reset();
+    PlaybackState state;
+    state.lyricsVersion = m_lyricsVersion;
+    WritePlayback(state);
 }
 
-bool LyricManager::HasLyric() const
+// Timeline the current line index refers to, nullptr without lyrics
+const LyricTimeline* LyricManager::ActiveTimeline(const SPlayerProtocol::LyricData& data) const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return !m_lyricData.empty();
+    if (m_enableYrc.load(std::memory_order_relaxed) && data.hasYrc())
+        return &data.yrcData;
+    if (data.hasLrc())
+        return &data.lrcData;
+    return nullptr;
 }
 
-bool LyricManager::HasYrcData() const
+std::wstring LyricManager::GetCurrentLyricText() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    return m_lyricData.hasYrc();
+    return std::wstring(GetFrame().CurrentLineText());
 }
 
-std::vector<SPlayerProtocol::YrcWord> LyricManager::GetCurrentYrcWords() const
+std::wstring LyricManager::GetNextLyricText() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    
-    if (!m_lyricData.hasYrc() || m_currentLineIndex < 0 || 
-        m_currentLineIndex >= (int)m_lyricData.yrcData.size())
-    {
-        return std::vector<SPlayerProtocol::YrcWord>();
-    }
-    
-    return m_lyricData.yrcData[m_currentLineIndex].words;
+    return std::wstring(GetFrame().NextLineText());
 }
 
-float LyricManager::GetWordProgress() const
+std::wstring LyricManager::GetCurrentTranslation() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
-    if (!g_config.Data().enableYrc || !m_lyricData.hasYrc())
-        return 1.0f;
-
-    if (m_currentLineIndex < 0 || m_currentLineIndex >= (int)m_lyricData.yrcData.size())
-        return 0.0f;
-
-    const auto& line = m_lyricData.yrcData[m_currentLineIndex];
-    if (line.words.empty())
-        return 1.0f;
-
-    int64_t lineStart = line.startTime;
-    int64_t lineEnd = line.endTime;
-
-    if (m_currentTime < lineStart)
-        return 0.0f;
-    if (m_currentTime >= lineEnd)
-        return 1.0f;
+    return std::wstring(GetFrame().CurrentTranslation());
+}
 
-    int64_t lineElapsed = m_currentTime - lineStart;
-    return static_cast<float>(lineElapsed) / static_cast<float>(lineEnd - lineStart);
+std::wstring LyricManager::GetSongInfoText() const
+{
+    return std::atomic_load(&m_songInfo)->displayText;
 }
 
-int LyricManager::FindCurrentLine(int64_t time) const
+bool LyricManager::HasLyric() const
 {
-    if (g_config.Data().enableYrc && m_lyricData.hasYrc())
-    {
-        for (int i = (int)m_lyricData.yrcData.size() - 1; i >= 0; --i)
-        {
-            if (time >= m_lyricData.yrcData[i].startTime)
-                return i;
-        }
-    }
-    else if (m_lyricData.hasLrc())
-    {
-        for (int i = (int)m_lyricData.lrcData.size() - 1; i >= 0; --i)
-        {
-            if (time >= m_lyricData.lrcData[i].time)
-                return i;
-        }
-    }
+    return !LoadLyrics()->data.empty();
+}
 
-    return -1;
+bool LyricManager::HasYrcData() const
+{
+    return LoadLyrics()->data.hasYrc();
 }
 
 int64_t LyricManager::GetCurrentTime() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (!m_isPlaying)
-    {
-        return m_currentTime + g_config.Data().lyricOffset;
-    }
-    
-    // Extrapolate
-    int64_t elapsed = GetTickCount64() - m_lastUpdateTick;
-    // Cap extrapolation to avoid running too far ahead if connection lost
-    if (elapsed > 2000) elapsed = 2000;
-    
-    return m_currentTime + elapsed + g_config.Data().lyricOffset;
+    return (int64_t)ReadPlayback().clock.PositionAt(PlaybackClock::NowUs()) + m_lyricOffset.load(std::memory_order_relaxed);
 }
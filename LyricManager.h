@@ -1,25 +1,115 @@
 /*
  * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
- * 
+ *
  * Lyric Manager Interface
  */
 
 #pragma once
 
 #include "SPlayerProtocol.h"
+#include "PlaybackClock.h"
+#include <atomic>
+#include <memory>
 #include <mutex>
 
+// Readers never lock. Lyrics and song info are published as immutable
+// snapshots behind a shared_ptr (swapped atomically, old ones are freed when
+// the last reader lets go), and the playback position sits behind a seqlock.
+// Writers (the WebSocket thread, Clear) serialize on m_writeMutex only.
 class LyricManager
 {
 public:
+    // Lyrics of one song, never modified once published
+    struct LyricSnapshot
+    {
+        SPlayerProtocol::LyricData data;
+        uint64_t version = 0;
+    };
+
+    struct PlaybackState
+    {
+        PlaybackClock::Segment clock;   // Smoothed position between reports
+        int64_t currentTime = 0;        // As reported by SPlayer, without offset
+        int lineIndex = -1;             // Line of the lyrics with lyricsVersion
+        uint64_t lyricsVersion = 0;
+        bool isPlaying = false;
+    };
+
+    // Word highlight of the current YRC line. Words before activeWord are
+    // fully sung, words after it not at all; only activeWord is partial.
+    struct Highlight
+    {
+        size_t completedWords = 0;
+        int activeWord = -1;            // completedWords while words remain, else -1
+        float activeProgress = 0.0f;    // 0..1, stays 0 in a gap before the word starts
+    };
+
+    // Song info with its display string built once on publish
+    struct SongSnapshot
+    {
+        SPlayerProtocol::SongInfo info;
+        std::wstring displayText;       // Title, or "name - artist"
+        uint64_t version = 0;
+    };
+
+    // Everything a render pass needs, taken at once so it is self-consistent.
+    // The text accessors return views into the snapshots the frame holds, so
+    // they stay valid for as long as the frame and never allocate.
+    struct Frame
+    {
+        std::shared_ptr<const LyricSnapshot> lyrics;
+        std::shared_ptr<const SongSnapshot> song;
+        PlaybackState playback;
+        int64_t currentTime = 0;                    // Estimated position with lyric offset
+        const LyricTimeline* timeline = nullptr;    // YRC or LRC, per Options
+        int lineIndex = -1;                         // Into timeline at currentTime, -1 for none
+        Highlight highlight;                        // For CurrentYrcWords() at currentTime
+
+        std::wstring_view CurrentLineText() const { return LineText(lineIndex); }
+        std::wstring_view NextLineText() const { return lineIndex >= 0 ? LineText(lineIndex + 1) : std::wstring_view(); }
+        std::wstring_view CurrentTranslation() const
+        {
+            return HasLine(lineIndex) ? timeline->LineTranslation(lineIndex) : std::wstring_view();
+        }
+        std::wstring_view SongInfoText() const { return song->displayText; }
+
+        // Words of the current line when YRC is the active timeline. Together
+        // with lyrics->version and lineIndex this identifies the line, so a
+        // renderer can tell "same line as last frame" without comparing text.
+        LyricTimeline::LineWords CurrentYrcWords() const
+        {
+            if (!HasLine(lineIndex) || timeline != &lyrics->data.yrcData)
+                return LyricTimeline::LineWords();
+            return timeline->Words(lineIndex);
+        }
+
+    private:
+        bool HasLine(int index) const { return timeline && index >= 0 && index < (int)timeline->LineCount(); }
+        std::wstring_view LineText(int index) const
+        {
+            return HasLine(index) ? timeline->LineText(index) : std::wstring_view();
+        }
+    };
+
+    // Settings the lookups depend on. Whoever loads or changes Config passes
+    // them in; readers pick them up on their next frame.
+    struct Options
+    {
+        bool enableYrc = false;     // Follow yrcData when the song has it
+        int lyricOffset = 0;        // ms added to the playback position
+    };
+
     static LyricManager& Instance();
 
-    void UpdateLyrics(const SPlayerProtocol::LyricData& data);
+    void SetOptions(const Options& options);
+    void UpdateLyrics(SPlayerProtocol::LyricData&& data);
     void UpdateProgress(int64_t currentTime);
     void UpdateSongInfo(const SPlayerProtocol::SongInfo& info);
     void UpdatePlayStatus(bool isPlaying);
     void Clear();
 
+    Frame GetFrame() const;
+
     std::wstring GetCurrentLyricText() const;
     std::wstring GetNextLyricText() const;
     std::wstring GetCurrentTranslation() const;
@@ -27,27 +117,38 @@ public:
 
     bool HasLyric() const;
     bool HasYrcData() const;
-    bool IsPlaying() const { return m_isPlaying; }
-    int GetCurrentLineIndex() const { return m_currentLineIndex; }
-    float GetWordProgress() const;
+    bool IsPlaying() const { return ReadPlayback().isPlaying; }
+    int GetCurrentLineIndex() const { return GetFrame().lineIndex; }
     int64_t GetCurrentTime() const;
-    
-    std::vector<SPlayerProtocol::YrcWord> GetCurrentYrcWords() const;
 
 private:
-    LyricManager() = default;
-    int FindCurrentLine(int64_t time) const;
-    int64_t GetTimeWithOffset() const;
+    LyricManager();
+    const LyricTimeline* ActiveTimeline(const SPlayerProtocol::LyricData& data) const;
+
+    std::shared_ptr<const LyricSnapshot> LoadLyrics() const { return std::atomic_load(&m_lyrics); }
+    PlaybackState ReadPlayback() const;
+    Highlight ComputeHighlight(const Frame& frame) const;
+    void WritePlayback(const PlaybackState& state);
+
+    std::mutex m_writeMutex;
+    uint64_t m_lyricsVersion = 0;
+    uint64_t m_songVersion = 0;
+    PlaybackClock m_clock;              // Filter state, written under m_writeMutex
+
+    std::shared_ptr<const LyricSnapshot> m_lyrics;
+    std::shared_ptr<const SongSnapshot> m_songInfo;
 
-    mutable std::mutex m_mutex;
+    std::atomic<bool> m_enableYrc{ false };
+    std::atomic<int> m_lyricOffset{ 0 };
 
-    SPlayerProtocol::LyricData m_lyricData;
-    SPlayerProtocol::SongInfo m_songInfo;
+    // Seqlock over PlaybackState, copied word by word; odd while a write is in progress
+    static const size_t PLAYBACK_WORDS = (sizeof(PlaybackState) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    std::atomic<uint32_t> m_playbackSeq{ 0 };
+    std::atomic<uint64_t> m_playback[PLAYBACK_WORDS];
 
-    int64_t m_currentTime = 0;
-    int64_t m_lastUpdateTick = 0;
-    int m_currentLineIndex = -1;
-    bool m_isPlaying = false;
+    // Word cursor hint shared by all readers: line index in the high half,
+    // completed word count in the low half. Always validated before use.
+    mutable std::atomic<uint64_t> m_wordCursor{ 0 };
 };
 
 #define g_lyricMgr LyricManager::Instance()
@@ -0,0 +1,220 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Flat Lyric Timeline Storage Implementation
+ */
+
+#include "pch.h"
+#include "LyricTimeline.h"
+#include "TextEncoding.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+template <typename T>
+static size_t VectorBytes(const std::vector<T>& v)
+{
+    return v.capacity() * sizeof(T);
+}
+
+size_t LyricTimeline::MemoryUsage() const
+{
+    return sizeof(*this)
+        + m_text.capacity() * sizeof(wchar_t)
+        + VectorBytes(m_lineStart) + VectorBytes(m_lineEnd)
+        + VectorBytes(m_lineText) + VectorBytes(m_lineTranslation)
+        + VectorBytes(m_lineWordEnd)
+        + VectorBytes(m_wordStart) + VectorBytes(m_wordDuration)
+        + VectorBytes(m_wordText) + VectorBytes(m_wordSettled);
+}
+
+int LyricTimeline::FindLine(int64_t time, int hint) const
+{
+    if (m_lineStart.empty() || time < m_lineStart[0])
+        return -1;
+
+    if (hint >= 0 && (size_t)hint < m_lineStart.size())
+    {
+        if (LineContains(hint, time))
+            return hint;
+        if ((size_t)hint + 1 < m_lineStart.size() && LineContains(hint + 1, time))
+            return hint + 1;
+        if (hint > 0 && LineContains(hint - 1, time))
+            return hint - 1;
+    }
+
+    // Seek: last line whose start is not after time
+    auto it = std::upper_bound(m_lineStart.begin(), m_lineStart.end(), time);
+    return (int)(it - m_lineStart.begin()) - 1;
+}
+
+size_t LyricTimeline::CompletedWords(size_t line, int64_t time, size_t hint) const
+{
+    size_t begin = WordBegin(line);
+    size_t end = WordEnd(line);
+    size_t word = begin + (std::min)(hint, end - begin);
+
+    // m_wordSettled rises monotonically within a line, so the cursor just
+    // steps back when time went backwards (seek, clock correction) and
+    // forward otherwise. Zero-length words complete as soon as they start.
+    while (word > begin && m_wordSettled[word - 1] > time)
+        --word;
+    while (word < end && m_wordSettled[word] <= time)
+        ++word;
+
+    return word - begin;
+}
+
+void LyricTimeline::BeginLine()
+{
+    m_pendingLineOffset = m_text.size();
+    m_pendingFirstWord = m_wordStart.size();
+    m_pendingTranslation.clear();
+}
+
+void LyricTimeline::AppendLineText(std::string_view utf8)
+{
+    DecodeUtf8Append(m_text, utf8);
+}
+
+void LyricTimeline::SetLineTranslation(std::string_view utf8)
+{
+    // Held aside until the line ends so the line's own text stays contiguous
+    m_pendingTranslation.clear();
+    DecodeUtf8Append(m_pendingTranslation, utf8);
+}
+
+void LyricTimeline::BeginWord()
+{
+    m_pendingWordOffset = m_text.size();
+}
+
+void LyricTimeline::AppendWordText(std::string_view utf8)
+{
+    DecodeUtf8Append(m_text, utf8);
+}
+
+void LyricTimeline::EndWord(int64_t startTime, int64_t endTime)
+{
+    size_t length = m_text.size() - m_pendingWordOffset;
+    if (length == 0)
+        return;
+
+    m_wordStart.push_back(startTime);
+    m_wordDuration.push_back(static_cast<int32_t>(endTime - startTime));
+    m_wordText.push_back({ static_cast<uint32_t>(m_pendingWordOffset), static_cast<uint32_t>(length) });
+}
+
+void LyricTimeline::EndLine(int64_t startTime, int64_t endTime)
+{
+    size_t length = m_text.size() - m_pendingLineOffset;
+    if (length == 0)
+    {
+        // Nothing to show: forget any words recorded for it
+        m_wordStart.resize(m_pendingFirstWord);
+        m_wordDuration.resize(m_pendingFirstWord);
+        m_wordText.resize(m_pendingFirstWord);
+        m_pendingTranslation.clear();
+        return;
+    }
+
+    m_lineStart.push_back(startTime);
+    m_lineEnd.push_back(endTime);
+    m_lineText.push_back({ static_cast<uint32_t>(m_pendingLineOffset), static_cast<uint32_t>(length) });
+
+    TextSpan translation;
+    if (!m_pendingTranslation.empty())
+    {
+        translation.offset = static_cast<uint32_t>(m_text.size());
+        translation.length = static_cast<uint32_t>(m_pendingTranslation.size());
+        m_text += m_pendingTranslation;
+        m_pendingTranslation.clear();
+    }
+    m_lineTranslation.push_back(translation);
+    m_lineWordEnd.push_back(static_cast<uint32_t>(m_wordStart.size()));
+}
+
+// Reorder lines (and their words) by start time. Text stays where it is in
+// the arena, only the spans move.
+void LyricTimeline::SortLines()
+{
+    std::vector<uint32_t> order(m_lineStart.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b)
+    {
+        return m_lineStart[a] < m_lineStart[b];
+    });
+
+    LyricTimeline sorted;
+    sorted.m_lineStart.reserve(order.size());
+    sorted.m_lineEnd.reserve(order.size());
+    sorted.m_lineText.reserve(order.size());
+    sorted.m_lineTranslation.reserve(order.size());
+    sorted.m_lineWordEnd.reserve(order.size());
+    sorted.m_wordStart.reserve(m_wordStart.size());
+    sorted.m_wordDuration.reserve(m_wordDuration.size());
+    sorted.m_wordText.reserve(m_wordText.size());
+
+    for (uint32_t line : order)
+    {
+        sorted.m_lineStart.push_back(m_lineStart[line]);
+        sorted.m_lineEnd.push_back(m_lineEnd[line]);
+        sorted.m_lineText.push_back(m_lineText[line]);
+        sorted.m_lineTranslation.push_back(m_lineTranslation[line]);
+        for (size_t word = WordBegin(line); word < WordEnd(line); ++word)
+        {
+            sorted.m_wordStart.push_back(m_wordStart[word]);
+            sorted.m_wordDuration.push_back(m_wordDuration[word]);
+            sorted.m_wordText.push_back(m_wordText[word]);
+        }
+        sorted.m_lineWordEnd.push_back(static_cast<uint32_t>(sorted.m_wordStart.size()));
+    }
+
+    m_lineStart.swap(sorted.m_lineStart);
+    m_lineEnd.swap(sorted.m_lineEnd);
+    m_lineText.swap(sorted.m_lineText);
+    m_lineTranslation.swap(sorted.m_lineTranslation);
+    m_lineWordEnd.swap(sorted.m_lineWordEnd);
+    m_wordStart.swap(sorted.m_wordStart);
+    m_wordDuration.swap(sorted.m_wordDuration);
+    m_wordText.swap(sorted.m_wordText);
+}
+
+void LyricTimeline::Finish()
+{
+    // Lookups rely on ordered start times; SPlayer normally sends them sorted
+    if (!std::is_sorted(m_lineStart.begin(), m_lineStart.end()))
+        SortLines();
+
+    // Running maximum of word end times, for the word cursor
+    m_wordSettled.resize(m_wordStart.size());
+    for (size_t line = 0; line < m_lineStart.size(); ++line)
+    {
+        int64_t settled = (std::numeric_limits<int64_t>::min)();
+        for (size_t word = WordBegin(line); word < WordEnd(line); ++word)
+        {
+            settled = (std::max)(settled, m_wordStart[word] + m_wordDuration[word]);
+            m_wordSettled[word] = settled;
+        }
+    }
+
+    // Lines without an end time (LRC) last until the next line starts
+    for (size_t i = 0; i < m_lineStart.size(); ++i)
+    {
+        if (m_lineEnd[i] <= m_lineStart[i])
+            m_lineEnd[i] = i + 1 < m_lineStart.size() ? m_lineStart[i + 1] : m_lineStart[i];
+    }
+
+    // Growth slack from parsing is dropped once; the timeline never changes again
+    m_text.shrink_to_fit();
+    m_lineStart.shrink_to_fit();
+    m_lineEnd.shrink_to_fit();
+    m_lineText.shrink_to_fit();
+    m_lineTranslation.shrink_to_fit();
+    m_lineWordEnd.shrink_to_fit();
+    m_wordStart.shrink_to_fit();
+    m_wordDuration.shrink_to_fit();
+    m_wordText.shrink_to_fit();
+    m_wordSettled.shrink_to_fit();
+    std::wstring().swap(m_pendingTranslation);
+}
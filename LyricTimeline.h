@@ -0,0 +1,132 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Flat Lyric Timeline Storage
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Lyric lines and their words stored as parallel arrays. All text of a song
+// lives in one UTF-16 arena; lines and words refer to it by offset/length.
+// A line's words are stored back to back in the arena, so the full line text
+// is itself just one span and never has to be concatenated.
+//
+// Built once by the lyric-change decoder, read-only afterwards.
+class LyricTimeline
+{
+public:
+    struct TextSpan
+    {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    struct Word
+    {
+        int64_t startTime;
+        int64_t duration;
+        std::wstring_view text;
+    };
+
+    // Words of one line: a small handle into the timeline, valid for as long
+    // as the timeline is. Copying it copies no text.
+    class LineWords
+    {
+    public:
+        LineWords() = default;
+        LineWords(const LyricTimeline* timeline, size_t begin, size_t end)
+            : m_timeline(timeline), m_begin(begin), m_end(end) {}
+
+        size_t size() const { return m_end - m_begin; }
+        bool empty() const { return m_begin == m_end; }
+        Word operator[](size_t i) const
+        {
+            size_t word = m_begin + i;
+            return { m_timeline->WordStart(word), m_timeline->WordDuration(word), m_timeline->WordText(word) };
+        }
+
+    private:
+        const LyricTimeline* m_timeline = nullptr;
+        size_t m_begin = 0;
+        size_t m_end = 0;
+    };
+
+    size_t LineCount() const { return m_lineStart.size(); }
+    bool empty() const { return m_lineStart.empty(); }
+
+    int64_t LineStart(size_t line) const { return m_lineStart[line]; }
+    int64_t LineEnd(size_t line) const { return m_lineEnd[line]; }
+    std::wstring_view LineText(size_t line) const { return Text(m_lineText[line]); }
+    std::wstring_view LineTranslation(size_t line) const { return Text(m_lineTranslation[line]); }
+
+    // Index of the line playing at time (the last one starting at or before
+    // it), or -1 before the first line. hint is the previous result: during
+    // playback the answer is almost always the hinted line or a neighbour, so
+    // those are tried before falling back to a binary search.
+    int FindLine(int64_t time, int hint = -1) const;
+
+    // Words of a line are the index range [WordBegin(line), WordEnd(line))
+    size_t WordBegin(size_t line) const { return line == 0 ? 0 : m_lineWordEnd[line - 1]; }
+    size_t WordEnd(size_t line) const { return m_lineWordEnd[line]; }
+    size_t WordCount() const { return m_wordStart.size(); }
+    LineWords Words(size_t line) const { return LineWords(this, WordBegin(line), WordEnd(line)); }
+
+    // Number of leading words of a line that have finished at time, i.e. the
+    // word cursor. An overlapping word counts once every earlier word has
+    // ended too. hint is an earlier result for the same line; playback moves
+    // the cursor forward a word at a time, so the search starts there.
+    size_t CompletedWords(size_t line, int64_t time, size_t hint = 0) const;
+
+    int64_t WordStart(size_t word) const { return m_wordStart[word]; }
+    int64_t WordDuration(size_t word) const { return m_wordDuration[word]; }
+    std::wstring_view WordText(size_t word) const { return Text(m_wordText[word]); }
+
+    // Bytes held by the timeline, for diagnostics
+    size_t MemoryUsage() const;
+
+    // Building. Text is UTF-8 and decoded straight into the arena.
+    void BeginLine();
+    void AppendLineText(std::string_view utf8);         // Untimed text (LRC)
+    void SetLineTranslation(std::string_view utf8);
+    void BeginWord();
+    void AppendWordText(std::string_view utf8);
+    void EndWord(int64_t startTime, int64_t endTime);    // Dropped if it has no text
+    void EndLine(int64_t startTime, int64_t endTime);    // Dropped if it has no text
+    void Finish();   // Sorts lines by start time and fills in missing end times
+
+private:
+    bool LineContains(size_t line, int64_t time) const
+    {
+        return m_lineStart[line] <= time && (line + 1 == m_lineStart.size() || time < m_lineStart[line + 1]);
+    }
+    void SortLines();
+
+    std::wstring_view Text(TextSpan span) const
+    {
+        return std::wstring_view(m_text.data() + span.offset, span.length);
+    }
+
+    std::wstring m_text;
+
+    std::vector<int64_t> m_lineStart;
+    std::vector<int64_t> m_lineEnd;
+    std::vector<TextSpan> m_lineText;
+    std::vector<TextSpan> m_lineTranslation;
+    std::vector<uint32_t> m_lineWordEnd;
+
+    std::vector<int64_t> m_wordStart;
+    std::vector<int32_t> m_wordDuration;
+    std::vector<TextSpan> m_wordText;
+    std::vector<int64_t> m_wordSettled;     // When this word and all earlier ones of its line have ended
+
+    // Builder state
+    size_t m_pendingLineOffset = 0;
+    size_t m_pendingWordOffset = 0;
+    size_t m_pendingFirstWord = 0;
+    std::wstring m_pendingTranslation;
+};
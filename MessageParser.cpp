@@ -0,0 +1,331 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Streaming SPlayer Message Decoder Implementation
+ */
+
+#include "pch.h"
+#include "MessageParser.h"
+#include "TextEncoding.h"
+#include "nlohmann_json.hpp"
+
+using json = nlohmann::json;
+
+namespace
+{
+    // Where the parser currently is in the message
+    enum class Scope : uint8_t
+    {
+        Root,
+        Data,
+        LrcArray, YrcArray, TransArray,
+        LrcLine, YrcLine, TransLine,
+        Words,
+        Word,
+        Skip        // Anything we don't care about, including nested values
+    };
+
+    // Keys we act on, matched once when the key is read
+    enum class Field : uint8_t
+    {
+        Other,
+        Type,
+        Data,
+        LrcData, YrcData, TransData,
+        StartTime, EndTime,
+        Words, Word,
+        TranslatedLyric,
+        // Fields of the small messages
+        Status, Title, Name, Artist, Album, Duration, CurrentTime, Message
+    };
+
+    static Field MatchField(const std::string& key)
+    {
+        switch (key.size())
+        {
+        case 4:
+            if (key == "type") return Field::Type;
+            if (key == "data") return Field::Data;
+            if (key == "word") return Field::Word;
+            if (key == "name") return Field::Name;
+            break;
+        case 5:
+            if (key == "words") return Field::Words;
+            if (key == "title") return Field::Title;
+            if (key == "album") return Field::Album;
+            break;
+        case 6:
+            if (key == "status") return Field::Status;
+            if (key == "artist") return Field::Artist;
+            break;
+        case 7:
+            if (key == "lrcData") return Field::LrcData;
+            if (key == "yrcData") return Field::YrcData;
+            if (key == "endTime") return Field::EndTime;
+            if (key == "message") return Field::Message;
+            break;
+        case 8:
+            if (key == "duration") return Field::Duration;
+            break;
+        case 9:
+            if (key == "transData") return Field::TransData;
+            if (key == "startTime") return Field::StartTime;
+            break;
+        case 11:
+            if (key == "currentTime") return Field::CurrentTime;
+            break;
+        case 15:
+            if (key == "translatedLyric") return Field::TranslatedLyric;
+            break;
+        }
+        return Field::Other;
+    }
+
+    // SAX handler for nlohmann::json::sax_parse (static dispatch, no vtable).
+    // Lines and words are written straight into the LyricTimeline builders.
+    // "type" may come before or after "data", so the fields of every message
+    // type are collected and the caller looks at those of the type found.
+    class MessageSax
+    {
+    public:
+        explicit MessageSax(MessageParser::Message& out) : m_out(out), m_data(out.lyrics)
+        {
+            m_scopes.reserve(8);
+        }
+
+        bool null() { return true; }
+
+        bool boolean(bool val)
+        {
+            if (Top() == Scope::Data && m_field == Field::Status)
+                m_out.isPlaying = val;
+            return true;
+        }
+
+        bool number_integer(json::number_integer_t val) { return OnNumber(static_cast<int64_t>(val)); }
+        bool number_unsigned(json::number_unsigned_t val) { return OnNumber(static_cast<int64_t>(val)); }
+        bool number_float(json::number_float_t val, const json::string_t&) { return OnNumber(static_cast<int64_t>(val)); }
+        bool binary(json::binary_t&) { return true; }
+
+        bool string(json::string_t& val)
+        {
+            switch (Top())
+            {
+            case Scope::Root:
+                if (m_field == Field::Type)
+                    m_out.type = SPlayerProtocol::ParseMessageType(val);
+                break;
+            case Scope::Data:
+                switch (m_field)
+                {
+                case Field::Title: m_out.song.title = DecodeUtf8(val); break;
+                case Field::Name: m_out.song.name = DecodeUtf8(val); break;
+                case Field::Artist: m_out.song.artist = DecodeUtf8(val); break;
+                case Field::Album: m_out.song.album = DecodeUtf8(val); break;
+                case Field::Message: m_out.error = val; break;
+                default: break;
+                }
+                break;
+            case Scope::LrcLine:
+            case Scope::YrcLine:
+                if (m_field == Field::TranslatedLyric)
+                    m_timeline->SetLineTranslation(val);
+                break;
+            case Scope::TransLine:
+                if (m_field == Field::Word)
+                    m_timeline->AppendLineText(val);
+                break;
+            case Scope::Word:
+                if (m_field == Field::Word)
+                {
+                    // LRC lines only keep the combined text of their words
+                    if (m_wordsOwner == Scope::YrcLine)
+                        m_timeline->AppendWordText(val);
+                    else
+                        m_timeline->AppendLineText(val);
+                }
+                break;
+            default:
+                break;
+            }
+            return true;
+        }
+
+        bool key(json::string_t& val)
+        {
+            m_field = Top() == Scope::Skip ? Field::Other : MatchField(val);
+            return true;
+        }
+
+        bool start_object(std::size_t)
+        {
+            Scope scope = Scope::Skip;
+            if (m_scopes.empty())
+                scope = Scope::Root;
+            else
+            {
+                switch (Top())
+                {
+                case Scope::Root:
+                    if (m_field == Field::Data) scope = Scope::Data;
+                    break;
+                case Scope::LrcArray:
+                case Scope::YrcArray:
+                case Scope::TransArray:
+                    scope = Top() == Scope::LrcArray ? Scope::LrcLine
+                        : Top() == Scope::YrcArray ? Scope::YrcLine : Scope::TransLine;
+                    m_lineStart = 0;
+                    m_lineEnd = 0;
+                    m_timeline->BeginLine();
+                    break;
+                case Scope::Words:
+                    m_wordStart = 0;
+                    m_wordEnd = 0;
+                    if (m_wordsOwner == Scope::YrcLine)
+                        m_timeline->BeginWord();
+                    scope = Scope::Word;
+                    break;
+                default:
+                    break;
+                }
+            }
+            m_scopes.push_back(scope);
+            m_field = Field::Other;
+            return true;
+        }
+
+        bool end_object()
+        {
+            Scope scope = Top();
+            m_scopes.pop_back();
+
+            switch (scope)
+            {
+            case Scope::LrcLine:
+            case Scope::YrcLine:
+            case Scope::TransLine:
+                m_timeline->EndLine(m_lineStart, m_lineEnd);
+                break;
+            case Scope::Word:
+                if (m_wordsOwner == Scope::YrcLine)
+                    m_timeline->EndWord(m_wordStart, m_wordEnd);
+                break;
+            default:
+                break;
+            }
+            m_field = Field::Other;
+            return true;
+        }
+
+        bool start_array(std::size_t)
+        {
+            Scope scope = Scope::Skip;
+            switch (Top())
+            {
+            case Scope::Data:
+                if (m_field == Field::LrcData)
+                {
+                    scope = Scope::LrcArray;
+                    m_timeline = &m_data.lrcData;
+                }
+                else if (m_field == Field::YrcData)
+                {
+                    scope = Scope::YrcArray;
+                    m_timeline = &m_data.yrcData;
+                }
+                else if (m_field == Field::TransData)
+                {
+                    scope = Scope::TransArray;
+                    m_timeline = &m_data.transData;
+                }
+                break;
+            case Scope::LrcLine:
+            case Scope::YrcLine:
+                if (m_field == Field::Words)
+                {
+                    m_wordsOwner = Top();
+                    scope = Scope::Words;
+                }
+                break;
+            default:
+                break;
+            }
+            m_scopes.push_back(scope);
+            return true;
+        }
+
+        bool end_array()
+        {
+            m_scopes.pop_back();
+            m_field = Field::Other;
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&)
+        {
+            return false;
+        }
+
+    private:
+        Scope Top() const { return m_scopes.empty() ? Scope::Skip : m_scopes.back(); }
+
+        bool OnNumber(int64_t val)
+        {
+            switch (Top())
+            {
+            case Scope::Data:
+                if (m_field == Field::Duration)
+                {
+                    m_out.song.duration = val;
+                    m_out.progress.duration = val;
+                }
+                else if (m_field == Field::CurrentTime)
+                {
+                    m_out.progress.currentTime = val;
+                }
+                break;
+            case Scope::LrcLine:
+            case Scope::YrcLine:
+            case Scope::TransLine:
+                if (m_field == Field::StartTime) m_lineStart = val;
+                else if (m_field == Field::EndTime) m_lineEnd = val;
+                break;
+            case Scope::Word:
+                if (m_field == Field::StartTime) m_wordStart = val;
+                else if (m_field == Field::EndTime) m_wordEnd = val;
+                break;
+            default:
+                break;
+            }
+            return true;
+        }
+
+        MessageParser::Message& m_out;
+        SPlayerProtocol::LyricData& m_data;
+        std::vector<Scope> m_scopes;
+        Field m_field = Field::Other;
+
+        // Timeline, line and word being assembled
+        LyricTimeline* m_timeline = nullptr;
+        int64_t m_lineStart = 0;
+        int64_t m_lineEnd = 0;
+        int64_t m_wordStart = 0;
+        int64_t m_wordEnd = 0;
+        Scope m_wordsOwner = Scope::Skip;
+    };
+}
+
+bool MessageParser::Parse(std::string_view message, Message& out)
+{
+    MessageSax handler(out);
+    if (!json::sax_parse(message.begin(), message.end(), &handler))
+        return false;
+
+    if (out.type == SPlayerProtocol::MessageType::LyricChange)
+    {
+        out.lyrics.lrcData.Finish();
+        out.lyrics.yrcData.Finish();
+        out.lyrics.transData.Finish();
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Streaming SPlayer Message Decoder
+ */
+
+#pragma once
+
+#include "SPlayerProtocol.h"
+#include <string>
+#include <string_view>
+
+class MessageParser
+{
+public:
+    // One decoded message. Only the members for its type are filled in.
+    struct Message
+    {
+        SPlayerProtocol::MessageType type = SPlayerProtocol::MessageType::Unknown;
+        bool isPlaying = false;                     // status-change
+        SPlayerProtocol::SongInfo song;             // song-change
+        SPlayerProtocol::ProgressInfo progress;     // progress-change
+        std::string error = "Unknown error";        // error
+        SPlayerProtocol::LyricData lyrics;          // lyric-change
+    };
+
+    // Decode a message in one SAX pass, without building a JSON DOM.
+    // lyric-change lines and words go straight into the LyricData timelines;
+    // the small messages only pick out the fields of their "data" object.
+    // Returns false when the message is not valid JSON.
+    static bool Parse(std::string_view message, Message& out);
+};
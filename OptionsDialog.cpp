@@ -8,6 +8,7 @@
 #include <afxdlgs.h>
 #include "OptionsDialog.h"
 #include "Config.h"
+#include "LyricManager.h"
 
 int CALLBACK EnumFontFamExProc(const LOGFONTW* lpelfe, const TEXTMETRICW* lpntme, DWORD FontType, LPARAM lParam)
 {
@@ -164,4 +165,5 @@ void COptionsDialog::SaveSettings() {
     config.highlightColor = m_darkHighlightColor;
     config.normalColor = m_darkNormalColor;
     g_config.Save();
+    g_lyricMgr.SetOptions({ config.enableYrc, config.lyricOffset });
 }
@@ -0,0 +1,122 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Smoothed Playback Clock Implementation
+ */
+
+#include "pch.h"
+#include "PlaybackClock.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Forward errors beyond this are seeks (or a stale estimate) and are applied at once
+static const double SEEK_THRESHOLD_MS = 1000.0;
+// Samples this far behind the estimate are delivery jitter; further back is a seek
+static const double JITTER_MS = 150.0;
+// Window over which a phase correction is blended in
+static const double SLEW_MS = 250.0;
+// Share of the phase error corrected per sample; the rest waits for the next one
+static const double PHASE_GAIN = 0.5;
+// Share of each measured rate taken into the estimate
+static const double RATE_GAIN = 0.2;
+// Covers the playback speeds SPlayer offers
+static const double MIN_RATE = 0.25;
+static const double MAX_RATE = 4.0;
+// While slewing backwards the clock still advances at least this fraction of its rate
+static const double MIN_SLEW_SPEED = 0.25;
+// Stop extrapolating this long after the last sample, e.g. when the connection stalls
+static const double MAX_EXTRAPOLATION_MS = 2000.0;
+
+int64_t PlaybackClock::NowUs()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+double PlaybackClock::Segment::PositionAt(int64_t nowUs) const
+{
+    double elapsed = (nowUs - anchorUs) / 1000.0;
+    if (!playing || elapsed <= 0.0)
+        return base;
+
+    elapsed = (std::min)(elapsed, MAX_EXTRAPOLATION_MS);
+    return base + rate * elapsed + correction * ((std::min)(elapsed, SLEW_MS) / SLEW_MS);
+}
+
+void PlaybackClock::Reset()
+{
+    *this = PlaybackClock();
+}
+
+void PlaybackClock::Jump(int64_t position, int64_t nowUs)
+{
+    // Restart the rate filter: the first interval after the jump replaces
+    // the estimate instead of being blended into it
+    m_rateMeasured = false;
+
+    m_segment.base = (double)position;
+    m_segment.anchorUs = nowUs;
+    m_segment.rate = m_rate;
+    m_segment.correction = 0.0;
+}
+
+void PlaybackClock::AddSample(int64_t position, int64_t nowUs)
+{
+    if (!m_hasSample || !m_segment.playing)
+    {
+        Jump(position, nowUs);
+    }
+    else
+    {
+        double predicted = m_segment.PositionAt(nowUs);
+        double error = position - predicted;
+
+        // Rate over the interval since the last sample, when nothing but
+        // playback happened in it
+        double interval = (nowUs - m_lastSampleUs) / 1000.0;
+        bool measurable = m_canMeasureRate && interval > 0.0;
+        double measured = measurable ? (std::max)(MIN_RATE, (std::min)(MAX_RATE, (position - m_lastSamplePosition) / interval)) : m_rate;
+
+        if (error > SEEK_THRESHOLD_MS || error < -JITTER_MS)
+        {
+            // Right after a jump a large error is more likely a wrong rate
+            // than a second seek; keep the measurement provisionally
+            if (measurable && !m_rateMeasured)
+                m_rate = measured;
+            Jump(position, nowUs);
+        }
+        else
+        {
+            if (measurable)
+            {
+                m_rate = m_rateMeasured ? m_rate + RATE_GAIN * (measured - m_rate) : measured;
+                m_rateMeasured = true;
+            }
+
+            // Continue from the current estimate so the output has no step
+            m_segment.base = predicted;
+            m_segment.anchorUs = nowUs;
+            m_segment.rate = m_rate;
+            m_segment.correction = (std::max)(error * PHASE_GAIN, -(1.0 - MIN_SLEW_SPEED) * m_rate * SLEW_MS);
+        }
+    }
+
+    m_hasSample = true;
+    m_canMeasureRate = m_segment.playing;
+    m_lastSamplePosition = position;
+    m_lastSampleUs = nowUs;
+}
+
+void PlaybackClock::SetPlaying(bool playing, int64_t nowUs)
+{
+    if (playing == m_segment.playing)
+        return;
+
+    // Freeze (or restart) from wherever the estimate is right now
+    m_segment.base = m_segment.PositionAt(nowUs);
+    m_segment.anchorUs = nowUs;
+    m_segment.correction = 0.0;
+    m_segment.playing = playing;
+    m_canMeasureRate = false;
+}
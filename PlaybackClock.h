@@ -0,0 +1,59 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Smoothed Playback Clock
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Estimates the SPlayer playback position between progress-change messages.
+//
+// Progress samples arrive in order over one connection, but each one is
+// delayed by a varying amount. Every sample feeds a small PLL: the phase
+// error against the current estimate is slewed in over SLEW_MS instead of
+// being applied as a jump, and the rate is tracked from the advance between
+// consecutive samples, so playback at other speeds settles without a
+// standing error. Because every correction starts from the estimate at that
+// moment and the slewed speed is kept positive, the position never goes
+// backwards except on a seek (a backward error past the jitter window, or a
+// forward error past the seek threshold) or a stop.
+//
+// The filter itself is writer-only. What readers need is the current
+// Segment, a small trivially copyable value they evaluate on their own.
+class PlaybackClock
+{
+public:
+    // Position as a function of local time, valid from anchorUs on
+    struct Segment
+    {
+        double base = 0.0;          // Position (ms) at anchorUs
+        int64_t anchorUs = 0;       // NowUs() when the segment starts
+        double rate = 1.0;          // Playback ms per local ms
+        double correction = 0.0;    // Phase error (ms) slewed in after anchorUs
+        bool playing = false;
+
+        double PositionAt(int64_t nowUs) const;
+    };
+
+    // Microseconds on std::chrono::steady_clock (QueryPerformanceCounter on Windows)
+    static int64_t NowUs();
+
+    void Reset();
+    void AddSample(int64_t position, int64_t nowUs);
+    void SetPlaying(bool playing, int64_t nowUs);
+
+    const Segment& Current() const { return m_segment; }
+
+private:
+    void Jump(int64_t position, int64_t nowUs);
+
+    Segment m_segment;
+    double m_rate = 1.0;                // Smoothed rate estimate
+    bool m_hasSample = false;
+    bool m_rateMeasured = false;        // m_rate was measured since the last jump
+    bool m_canMeasureRate = false;      // Last sample starts a valid rate interval
+    int64_t m_lastSamplePosition = 0;
+    int64_t m_lastSampleUs = 0;
+};
@@ -0,0 +1,99 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Adaptive YRC Refresh Scheduling Implementation
+ */
+
+#include "pch.h"
+#include "RefreshScheduler.h"
+#include <algorithm>
+
+int RefreshScheduler::NextInterval(const Input& input)
+{
+    if (!input.yrcPlaying)
+        return MAX_INTERVAL_MS;
+
+    int64_t deadline = input.time + MAX_INTERVAL_MS;
+    auto consider = [&deadline](int64_t at)
+    {
+        deadline = (std::min)(deadline, at);
+    };
+
+    if (input.animationMs >= 0)
+        consider(input.time + input.animationMs);
+
+    if (input.hasActiveWord)
+    {
+        if (input.wordWidth <= 0)
+        {
+            // Not measured yet; poll until it is
+            consider(input.time);
+        }
+        else if (input.wordDuration > 0)
+        {
+            // fill = width * elapsed / duration; the next pixel column is
+            // reached once elapsed >= (fill + 1) * duration / width
+            int64_t elapsed = (std::max)((int64_t)0, input.time - input.wordStart);
+            int64_t fill = (std::min)((int64_t)input.wordWidth, elapsed * input.wordWidth / input.wordDuration);
+            if (fill < input.wordWidth)
+                consider(input.wordStart + ((fill + 1) * input.wordDuration + input.wordWidth - 1) / input.wordWidth);
+        }
+        else
+        {
+            // Zero-length words complete as soon as they start
+            consider(input.wordStart);
+        }
+    }
+
+    if (input.nextWordStart >= 0)
+        consider(input.nextWordStart);
+    if (input.nextLineStart >= 0)
+        consider(input.nextLineStart);
+
+    int64_t interval = deadline - input.time;
+    return (int)(std::max)((int64_t)MIN_INTERVAL_MS, (std::min)((int64_t)MAX_INTERVAL_MS, interval));
+}
+
+bool WakeupStats::Record(int64_t nowMs)
+{
+    if (m_secondStart < 0)
+        m_secondStart = nowMs;
+
+    bool completed = false;
+    while (nowMs - m_secondStart >= 1000)
+    {
+        completed |= CloseSecond(m_count);
+        m_count = 0;
+        m_secondStart += 1000;
+
+        // Asleep for longer than a window: nothing to report for it
+        if (nowMs - m_secondStart >= (int64_t)WINDOW_SECONDS * 1000)
+        {
+            m_secondStart = nowMs;
+            m_sampleCount = 0;
+        }
+    }
+
+    ++m_count;
+    return completed;
+}
+
+bool WakeupStats::CloseSecond(int count)
+{
+    m_samples[m_sampleCount++] = count;
+    if (m_sampleCount < WINDOW_SECONDS)
+        return false;
+
+    int total = 0;
+    for (int sample : m_samples)
+        total += sample;
+    m_average = (double)total / WINDOW_SECONDS;
+
+    int sorted[WINDOW_SECONDS];
+    std::copy(m_samples, m_samples + WINDOW_SECONDS, sorted);
+    std::sort(sorted, sorted + WINDOW_SECONDS);
+    m_p99 = sorted[(WINDOW_SECONDS * 99 + 99) / 100 - 1];
+
+    m_sampleCount = 0;
+    return true;
+}
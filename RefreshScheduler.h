@@ -0,0 +1,68 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Adaptive YRC Refresh Scheduling
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Picks when the next YRC repaint is worth doing. Instead of a fixed 16 ms
+// tick, the timer is re-armed for the earliest moment something on screen
+// can change: the active word's highlight growing by a pixel, the next
+// word or line starting, or the next step of a running animation. Held
+// notes and instrumental gaps then cost a few wakeups instead of sixty a
+// second.
+class RefreshScheduler
+{
+public:
+    // Never wake faster than the display can show it
+    static const int MIN_INTERVAL_MS = 16;
+    // Never sleep longer than this, so seeks and clock corrections are picked up
+    static const int MAX_INTERVAL_MS = 250;
+
+    struct Input
+    {
+        bool yrcPlaying = false;        // YRC shown and playing; otherwise only poll slowly
+        int64_t time = 0;               // Lyric time of the current frame (ms)
+        int64_t animationMs = -1;       // Until the animation moves next; -1 when none runs
+
+        // Active word of the current line; wordWidth 0 if it is not laid out
+        bool hasActiveWord = false;
+        int64_t wordStart = 0;
+        int64_t wordDuration = 0;
+        int wordWidth = 0;
+
+        int64_t nextWordStart = -1;     // -1 if the active word is the last one
+        int64_t nextLineStart = -1;     // -1 after the last line
+    };
+
+    // Milliseconds until the next repaint, within [MIN_INTERVAL_MS, MAX_INTERVAL_MS]
+    static int NextInterval(const Input& input);
+};
+
+// Timer wakeups per second over a window of whole seconds
+class WakeupStats
+{
+public:
+    static const size_t WINDOW_SECONDS = 60;
+
+    // Record a wakeup at nowMs (monotonic). Returns true when a window has
+    // just completed and Average/P99 describe it.
+    bool Record(int64_t nowMs);
+
+    double Average() const { return m_average; }
+    int P99() const { return m_p99; }
+
+private:
+    bool CloseSecond(int count);
+
+    int64_t m_secondStart = -1;
+    int m_count = 0;
+    int m_samples[WINDOW_SECONDS] = {};
+    size_t m_sampleCount = 0;
+    double m_average = 0.0;
+    int m_p99 = 0;
+};
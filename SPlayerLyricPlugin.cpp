@@ -89,6 +89,7 @@ void SPlayerLyricPlugin::OnExtenedInfo(ExtendedInfoIndex index, const wchar_t* d
     {
     case EI_CONFIG_DIR:
         g_config.Load(data);
+        g_lyricMgr.SetOptions({ g_config.Data().enableYrc, g_config.Data().lyricOffset });
 
         if (!m_initialized)
         {
@@ -172,10 +173,11 @@ void SPlayerLyricPlugin::InitWebSocketCallbacks()
         g_lyricMgr.UpdateProgress(info.currentTime);
     };
 
-    callbacks.onLyricChange = [this](const SPlayerProtocol::LyricData& data) {
-        g_lyricMgr.UpdateLyrics(data);
+    callbacks.onLyricChange = [this](SPlayerProtocol::LyricData&& data) {
+        bool hasYrc = data.hasYrc();
+        g_lyricMgr.UpdateLyrics(std::move(data));
         // Start high-frequency refresh if YRC data is available and playing
-        if (g_config.Data().enableYrc && data.hasYrc() && g_lyricMgr.IsPlaying())
+        if (g_config.Data().enableYrc && hasYrc && g_lyricMgr.IsPlaying())
         {
             m_lyricItem.StartHighFreqRefresh();
         }
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "LyricTimeline.h"
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -48,33 +49,13 @@ namespace SPlayerProtocol
         int64_t duration = 0;
     };
 
-    struct LrcLine
-    {
-        int64_t time = 0;
-        std::wstring text;
-        std::wstring translation;  // translatedLyric from SPlayer
-    };
-
-    struct YrcWord
-    {
-        int64_t startTime = 0;
-        int64_t duration = 0;
-        std::wstring text;
-    };
-
-    struct YrcLine
-    {
-        int64_t startTime = 0;
-        int64_t endTime = 0;
-        std::vector<YrcWord> words;
-        std::wstring translation;  // translatedLyric from SPlayer
-    };
-
+    // Line translations (translatedLyric from SPlayer) are stored on the
+    // lrcData/yrcData lines themselves
     struct LyricData
     {
-        std::vector<LrcLine> lrcData;
-        std::vector<YrcLine> yrcData;
-        std::vector<LrcLine> transData;
+        LyricTimeline lrcData;
+        LyricTimeline yrcData;
+        LyricTimeline transData;
         bool hasYrc() const { return !yrcData.empty(); }
         bool hasLrc() const { return !lrcData.empty(); }
         bool empty() const { return lrcData.empty() && yrcData.empty(); }
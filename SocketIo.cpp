@@ -0,0 +1,177 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Non-blocking Socket I/O Implementation
+ */
+
+#include "pch.h"
+#include "SocketIo.h"
+#include <climits>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+namespace SocketIo
+{
+    // Frames are a header and a payload; a few more leave room
+    static const size_t MAX_SEND_BUFFERS = 4;
+
+#ifdef _WIN32
+    static int Poll(SocketHandle socket, short events, int timeoutMs, short& revents)
+    {
+        WSAPOLLFD pfd = {};
+        pfd.fd = socket;
+        pfd.events = events;
+        int result = WSAPoll(&pfd, 1, timeoutMs);
+        revents = pfd.revents;
+        return result == SOCKET_ERROR ? -1 : result;
+    }
+
+    static bool WouldBlock()
+    {
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    }
+
+    static bool Interrupted()
+    {
+        return false;
+    }
+
+    // Returns the bytes sent, or -1 on error
+    static long long Send(SocketHandle socket, const SendBuffer* buffers, size_t count)
+    {
+        WSABUF wsaBuffers[MAX_SEND_BUFFERS];
+        for (size_t i = 0; i < count; ++i)
+        {
+            wsaBuffers[i].buf = const_cast<CHAR*>(buffers[i].data);
+            wsaBuffers[i].len = static_cast<ULONG>(buffers[i].size);
+        }
+
+        DWORD sent = 0;
+        if (WSASend(socket, wsaBuffers, static_cast<DWORD>(count), &sent, 0, nullptr, nullptr) == SOCKET_ERROR)
+            return -1;
+        return sent;
+    }
+#else
+    static int Poll(SocketHandle socket, short events, int timeoutMs, short& revents)
+    {
+        pollfd pfd = {};
+        pfd.fd = socket;
+        pfd.events = events;
+        int result = poll(&pfd, 1, timeoutMs);
+        revents = pfd.revents;
+        return result;
+    }
+
+    static bool WouldBlock()
+    {
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+
+    static bool Interrupted()
+    {
+        return errno == EINTR;
+    }
+
+    static long long Send(SocketHandle socket, const SendBuffer* buffers, size_t count)
+    {
+        iovec vectors[MAX_SEND_BUFFERS];
+        for (size_t i = 0; i < count; ++i)
+        {
+            vectors[i].iov_base = const_cast<char*>(buffers[i].data);
+            vectors[i].iov_len = buffers[i].size;
+        }
+
+        msghdr message = {};
+        message.msg_iov = vectors;
+        message.msg_iovlen = count;
+        // A closed peer is an error to report, not a signal to die of
+        return sendmsg(socket, &message, MSG_NOSIGNAL);
+    }
+#endif
+
+    Status WaitReadable(SocketHandle socket, int timeoutMs)
+    {
+        short revents = 0;
+        int result = Poll(socket, POLLRDNORM, timeoutMs, revents);
+        if (result > 0)
+            return (revents & POLLNVAL) ? Status::Failed : Status::Ready;
+        if (result == 0 || Interrupted())
+            return Status::Timeout;
+        return Status::Failed;
+    }
+
+    Status WaitWritable(SocketHandle socket, int timeoutMs)
+    {
+        short revents = 0;
+        int result = Poll(socket, POLLWRNORM, timeoutMs, revents);
+        if (result > 0)
+            return (revents & (POLLNVAL | POLLERR | POLLHUP)) ? Status::Failed : Status::Ready;
+        if (result == 0 || Interrupted())
+            return Status::Timeout;
+        return Status::Failed;
+    }
+
+    Status Receive(SocketHandle socket, char* dst, size_t capacity, size_t& received)
+    {
+        received = 0;
+        int result = recv(socket, dst, (int)(capacity < (size_t)INT_MAX ? capacity : (size_t)INT_MAX), 0);
+        if (result > 0)
+        {
+            received = (size_t)result;
+            return Status::Ready;
+        }
+        if (result == 0)
+            return Status::Closed;
+        return WouldBlock() || Interrupted() ? Status::WouldBlock : Status::Failed;
+    }
+
+    Status SendAll(SocketHandle socket, SendBuffer* buffers, size_t count, int timeoutMs)
+    {
+        while (count > 0 && buffers[0].size == 0)
+        {
+            ++buffers;
+            --count;
+        }
+        if (count > MAX_SEND_BUFFERS)
+            return Status::Failed;
+
+        while (count > 0)
+        {
+            long long sent = Send(socket, buffers, count);
+            if (sent < 0)
+            {
+                if (Interrupted())
+                    continue;
+                if (!WouldBlock())
+                    return Status::Failed;
+
+                Status wait = WaitWritable(socket, timeoutMs);
+                if (wait != Status::Ready)
+                    return wait;
+                continue;
+            }
+
+            // Step past what went out; a short write leaves the rest for the next round
+            size_t remaining = (size_t)sent;
+            while (count > 0 && remaining >= buffers[0].size)
+            {
+                remaining -= buffers[0].size;
+                buffers[0].data += buffers[0].size;
+                buffers[0].size = 0;
+                ++buffers;
+                --count;
+            }
+            if (count > 0)
+            {
+                buffers[0].data += remaining;
+                buffers[0].size -= remaining;
+            }
+        }
+        return Status::Ready;
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Non-blocking Socket I/O
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+typedef SOCKET SocketHandle;
+#else
+typedef int SocketHandle;
+#endif
+
+// The few socket calls the client needs, on WSAPoll/recv/WSASend on Windows
+// and poll/recv/sendmsg elsewhere, so the readiness logic can be exercised in
+// the Linux tests. The socket is expected to be non-blocking.
+namespace SocketIo
+{
+    enum class Status
+    {
+        Ready,          // Wait: ready. Receive: received > 0 bytes. SendAll: all sent.
+        Timeout,        // Wait and SendAll: nothing happened within the timeout
+        WouldBlock,     // Receive only: no data right now
+        Closed,         // Receive only: the peer closed the connection
+        Failed,
+    };
+
+    // Wait until the socket is readable. Hang-up and error conditions count
+    // as readable: the following Receive reports what actually happened.
+    Status WaitReadable(SocketHandle socket, int timeoutMs);
+
+    // Wait until the socket has room to send
+    Status WaitWritable(SocketHandle socket, int timeoutMs);
+
+    // Receive what is available, up to capacity bytes, without blocking
+    Status Receive(SocketHandle socket, char* dst, size_t capacity, size_t& received);
+
+    struct SendBuffer
+    {
+        const char* data;
+        size_t size;
+    };
+
+    // Gather-write the buffers in full. Short writes continue with the rest,
+    // and a full send buffer is waited out for up to timeoutMs at a time.
+    // The buffers are advanced past what was sent; on any status but Ready
+    // part of the data may already be on the wire.
+    Status SendAll(SocketHandle socket, SendBuffer* buffers, size_t count, int timeoutMs);
+}
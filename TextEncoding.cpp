@@ -0,0 +1,162 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * UTF-8 to UTF-16 Transcoding Implementation
+ */
+
+#include "pch.h"
+#include "TextEncoding.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define TEXT_ENCODING_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static const char32_t REPLACEMENT_CHAR = 0xFFFD;
+
+// Widen a run of ASCII bytes. Returns how many bytes were consumed; stops at
+// the first byte with the high bit set.
+template <typename Unit>
+static size_t WidenAscii(Unit* dst, const unsigned char* src, size_t len)
+{
+    size_t i = 0;
+
+#ifdef TEXT_ENCODING_SSE2
+    if (sizeof(Unit) == 2)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= len; i += 16)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            if (_mm_movemask_epi8(bytes) != 0)
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi8(bytes, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), _mm_unpackhi_epi8(bytes, zero));
+        }
+    }
+#endif
+
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, src + i, 8);
+        if (word & 0x8080808080808080ull)
+            break;
+        for (size_t k = 0; k < 8; k++)
+            dst[i + k] = static_cast<Unit>(src[i + k]);
+    }
+
+    for (; i < len && src[i] < 0x80; i++)
+        dst[i] = static_cast<Unit>(src[i]);
+
+    return i;
+}
+
+// Decode one multi-byte sequence starting at src[0] (which is >= 0x80).
+// Returns the code point, or -1 if malformed; length is always >= 1.
+static int32_t DecodeSequence(const unsigned char* src, size_t available, size_t& length)
+{
+    unsigned char lead = src[0];
+    int32_t cp;
+    size_t need;
+    unsigned char lo = 0x80, hi = 0xBF;   // Allowed range for the second byte
+
+    length = 1;
+    if (lead >= 0xC2 && lead <= 0xDF)
+    {
+        cp = lead & 0x1F;
+        need = 1;
+    }
+    else if (lead >= 0xE0 && lead <= 0xEF)
+    {
+        cp = lead & 0x0F;
+        need = 2;
+        if (lead == 0xE0) lo = 0xA0;        // Overlong
+        else if (lead == 0xED) hi = 0x9F;   // Surrogates
+    }
+    else if (lead >= 0xF0 && lead <= 0xF4)
+    {
+        cp = lead & 0x07;
+        need = 3;
+        if (lead == 0xF0) lo = 0x90;        // Overlong
+        else if (lead == 0xF4) hi = 0x8F;   // Above U+10FFFF
+    }
+    else
+    {
+        return -1;
+    }
+
+    for (size_t k = 1; k <= need; k++)
+    {
+        if (k >= available)
+            return -1;
+        unsigned char c = src[k];
+        if (k == 1 ? (c < lo || c > hi) : (c & 0xC0) != 0x80)
+            return -1;
+        cp = (cp << 6) | (c & 0x3F);
+        length = k + 1;
+    }
+    return cp;
+}
+
+template <typename Unit>
+static size_t DecodeAppend(std::basic_string<Unit>& out, std::string_view utf8)
+{
+    if (utf8.empty())
+        return 0;
+
+    // UTF-16 never needs more units than UTF-8 has bytes
+    size_t start = out.size();
+    out.resize(start + utf8.size());
+    Unit* dst = &out[start];
+
+    const unsigned char* src = reinterpret_cast<const unsigned char*>(utf8.data());
+    size_t len = utf8.size();
+    size_t i = 0;
+
+    while (i < len)
+    {
+        if (src[i] < 0x80)
+        {
+            size_t n = WidenAscii(dst, src + i, len - i);
+            dst += n;
+            i += n;
+            continue;
+        }
+
+        size_t seqLen;
+        int32_t cp = DecodeSequence(src + i, len - i, seqLen);
+        i += seqLen;
+
+        if (cp < 0)
+        {
+            *dst++ = static_cast<Unit>(REPLACEMENT_CHAR);
+        }
+        else if (cp >= 0x10000 && sizeof(Unit) == 2)
+        {
+            cp -= 0x10000;
+            *dst++ = static_cast<Unit>(0xD800 + (cp >> 10));
+            *dst++ = static_cast<Unit>(0xDC00 + (cp & 0x3FF));
+        }
+        else
+        {
+            *dst++ = static_cast<Unit>(cp);
+        }
+    }
+
+    size_t appended = dst - &out[start];
+    out.resize(start + appended);
+    return appended;
+}
+
+size_t DecodeUtf8Append(std::wstring& out, std::string_view utf8)
+{
+    return DecodeAppend(out, utf8);
+}
+
+size_t DecodeUtf8Append(std::u16string& out, std::string_view utf8)
+{
+    return DecodeAppend(out, utf8);
+}
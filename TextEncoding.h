@@ -0,0 +1,28 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * UTF-8 to UTF-16 Transcoding
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Decode UTF-8 and append it to out in one pass, so a whole line or message
+// can be collected into a single buffer. Runs of ASCII are widened 16 bytes
+// at a time. Malformed input (overlong forms, surrogates, truncated or stray
+// bytes) becomes U+FFFD, like MultiByteToWideChar without MB_ERR_INVALID_CHARS.
+// Returns the number of UTF-16 units appended.
+size_t DecodeUtf8Append(std::wstring& out, std::string_view utf8);
+
+// Same, always UTF-16. wchar_t is only 16 bits on Windows; elsewhere the
+// wstring overload produces UTF-32 and this one is what the tests check.
+size_t DecodeUtf8Append(std::u16string& out, std::string_view utf8);
+
+inline std::wstring DecodeUtf8(std::string_view utf8)
+{
+    std::wstring result;
+    DecodeUtf8Append(result, utf8);
+    return result;
+}
@@ -0,0 +1,38 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Text Extent Cache Implementation
+ */
+
+#include "pch.h"
+#include "TextMeasureCache.h"
+
+TextExtent TextMeasureCache::Measure(ITextMeasurer& measurer, std::wstring_view text)
+{
+    uint64_t font = measurer.FontId();
+    for (const Entry& entry : m_entries)
+    {
+        if (entry.valid && entry.fontId == font && entry.text == text)
+        {
+            ++m_stats.hits;
+            return entry.extent;
+        }
+    }
+
+    ++m_stats.misses;
+    Entry& entry = m_entries[m_nextSlot];
+    m_nextSlot = (m_nextSlot + 1) % CAPACITY;
+
+    entry.valid = true;
+    entry.fontId = font;
+    entry.text.assign(text.data(), text.length());
+    entry.extent = measurer.Measure(text);
+    return entry.extent;
+}
+
+void TextMeasureCache::Clear()
+{
+    for (Entry& entry : m_entries)
+        entry.valid = false;
+    m_nextSlot = 0;
+}
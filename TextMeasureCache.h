@@ -0,0 +1,38 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Text Extent Cache
+ */
+
+#pragma once
+
+#include "TextMeasurer.h"
+#include <string>
+
+// Extents of whole strings (plain lines, the second line, song info) keyed by
+// font id and content. The same handful of strings is drawn frame after
+// frame, so a small fixed table replaced round-robin covers them without
+// growing; a slot's string keeps its capacity, so refills rarely allocate.
+class TextMeasureCache
+{
+public:
+    static const size_t CAPACITY = 16;
+
+    TextExtent Measure(ITextMeasurer& measurer, std::wstring_view text);
+    void Clear();
+
+    const MeasureStats& Stats() const { return m_stats; }
+
+private:
+    struct Entry
+    {
+        bool valid = false;
+        uint64_t fontId = 0;
+        std::wstring text;
+        TextExtent extent;
+    };
+
+    Entry m_entries[CAPACITY];
+    size_t m_nextSlot = 0;
+    MeasureStats m_stats;
+};
@@ -0,0 +1,58 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Text Measurement Interface
+ */
+
+#pragma once
+
+#include <string_view>
+#include <cstdint>
+
+struct TextExtent
+{
+    int cx = 0;
+    int cy = 0;
+};
+
+// Hit/miss counters of a measurement cache, for the paint path only
+struct MeasureStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+
+    double HitRate() const
+    {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : (double)hits / (double)total;
+    }
+};
+
+// Measures text in one font. Keeps layout code independent of GDI, so it
+// can run outside the paint and be driven by a fake in isolation.
+class ITextMeasurer
+{
+public:
+    virtual ~ITextMeasurer() = default;
+
+    virtual TextExtent Measure(std::wstring_view text) = 0;
+
+    // Identifies the font (face, size, weight, DPI); equal ids measure alike
+    virtual uint64_t FontId() const = 0;
+};
+
+// FNV-1a over the parameters that determine a font's metrics
+inline uint64_t MakeFontId(std::wstring_view face, int height, int weight)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](uint64_t value)
+    {
+        hash ^= value;
+        hash *= 1099511628211ull;
+    };
+    for (wchar_t ch : face)
+        mix((uint64_t)ch);
+    mix((uint64_t)(uint32_t)height);
+    mix((uint64_t)(uint32_t)weight);
+    return hash;
+}
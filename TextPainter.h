@@ -0,0 +1,60 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Clipped Text Drawing
+ */
+
+#pragma once
+
+#include <Windows.h>
+#include <string_view>
+
+// Draws lyric text on the taskbar DC. Clipping is passed to ExtTextOutW as
+// an ETO_CLIPPED rectangle, so no region is created, selected and deleted
+// per word, and SetTextColor is only issued when the color changes.
+//
+// Every GDI call is counted; define SPLAYERLYRIC_GDI_STATS to have DrawItem
+// log the average per frame.
+class TextPainter
+{
+public:
+    // Start a frame on the given DC; the DC's text color is unknown until set
+    void Begin(HDC dc)
+    {
+        m_dc = dc;
+        m_color = CLR_INVALID;
+        m_calls = 0;
+    }
+
+    void SetColor(COLORREF color)
+    {
+        if (color == m_color)
+            return;
+        SetTextColor(m_dc, color);
+        m_color = color;
+        ++m_calls;
+    }
+
+    // Draw at (x, y), clipped to `clip` if given
+    void Draw(int x, int y, std::wstring_view text, const RECT* clip = nullptr)
+    {
+        ExtTextOutW(m_dc, x, y, clip != nullptr ? ETO_CLIPPED : 0, clip, text.data(), (UINT)text.length(), nullptr);
+        ++m_calls;
+    }
+
+    // Single line, cut with an ellipsis to fit the rectangle
+    void DrawEllipsis(RECT rect, std::wstring_view text)
+    {
+        DrawTextW(m_dc, text.data(), (int)text.length(), &rect,
+            DT_LEFT | DT_SINGLELINE | DT_END_ELLIPSIS | DT_NOPREFIX);
+        ++m_calls;
+    }
+
+    // Calls made by this painter since Begin
+    int Calls() const { return m_calls; }
+
+private:
+    HDC m_dc = nullptr;
+    COLORREF m_color = CLR_INVALID;
+    int m_calls = 0;
+};
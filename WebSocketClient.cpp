@@ -9,13 +9,15 @@
 #include "WebSocketClient.h"
 #include <ws2tcpip.h>
 #include "Config.h"
+#include "WebSocketMask.h"
+#include "SocketIo.h"
+#include "MessageParser.h"
 #include <sstream>
 #include <random>
 #include <algorithm>
 
-// Use nlohmann/json for robust JSON parsing
-#include "nlohmann_json.hpp"
-using json = nlohmann::json;
+// How long a send waits for room before the connection is given up
+static const int SEND_TIMEOUT_MS = 2000;
 
 static const char base64_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
@@ -74,16 +76,6 @@ static std::string GenerateWebSocketKey()
     return Base64Encode(key, 16);
 }
 
-static std::wstring Utf8ToWideLocal(const std::string& utf8)
-{
-    if (utf8.empty()) return std::wstring();
-    int size = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), (int)utf8.size(), nullptr, 0);
-    if (size <= 0) return std::wstring();
-    std::wstring result(size, 0);
-    MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), (int)utf8.size(), &result[0], size);
-    return result;
-}
-
 WebSocketClient& WebSocketClient::Instance()
 {
     static WebSocketClient instance;
@@ -94,6 +86,12 @@ WebSocketClient::WebSocketClient()
 {
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+    // Seed the mask generator once; random_device can be a syscall
+    std::random_device rd;
+    m_maskState = ((uint64_t)rd() << 32) ^ rd() ^ GetTickCount64();
+    if (m_maskState == 0)
+        m_maskState = 0x9E3779B97F4A7C15ull;
 }
 
 WebSocketClient::~WebSocketClient()
@@ -118,6 +116,8 @@ void WebSocketClient::Stop()
 
     if (m_socket != INVALID_SOCKET)
     {
+        // shutdown() wakes a pending WSAPoll in the worker thread
+        shutdown(m_socket, SD_BOTH);
         closesocket(m_socket);
         m_socket = INVALID_SOCKET;
     }
@@ -130,8 +130,7 @@ void WebSocketClient::Stop()
 
 void WebSocketClient::SetCallbacks(const WebSocketCallbacks& callbacks)
 {
-    std::lock_guard<std::mutex> lock(m_callbackMutex);
-    m_callbacks = callbacks;
+    std::atomic_store(&m_callbacks, std::make_shared<const WebSocketCallbacks>(callbacks));
 }
 
 void WebSocketClient::SendControl(SPlayerProtocol::ControlCommand cmd)
@@ -139,40 +138,29 @@ void WebSocketClient::SendControl(SPlayerProtocol::ControlCommand cmd)
     if (!m_connected)
         return;
 
-    std::string message = "{\"type\":\"control\",\"data\":{\"command\":\"";
-    message += SPlayerProtocol::CommandToString(cmd);
-    message += "\"}}";
+    // Serialize straight into the reusable send buffer
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    m_sendBuffer.assign("{\"type\":\"control\",\"data\":{\"command\":\"");
+    m_sendBuffer += SPlayerProtocol::CommandToString(cmd);
+    m_sendBuffer += "\"}}";
 
-    SendMessage(message);
+    SendFrameLocked(0x1);
 }
 
-// Read exactly n bytes from socket (blocking)
-bool WebSocketClient::ReadBytes(char* buffer, size_t n)
+// Text frames are messages from SPlayer, pings are answered right away
+void WebSocketClient::OnFrame(FrameDecoder::Event event, std::string_view data)
 {
-    size_t totalRead = 0;
-    while (totalRead < n && m_running && m_connected)
+    if (event == FrameDecoder::Event::Text)
     {
-        int result = recv(m_socket, buffer + totalRead, (int)(n - totalRead), 0);
-        if (result > 0)
-        {
-            totalRead += result;
-        }
-        else if (result == 0)
-        {
-            return false; // Connection closed
-        }
-        else
-        {
-            int err = WSAGetLastError();
-            if (err == WSAEWOULDBLOCK)
-            {
-                Sleep(10);
-                continue;
-            }
-            return false;
-        }
+        ParseMessage(data);
+    }
+    else if (event == FrameDecoder::Event::Ping)
+    {
+        // Pong echoes the ping's application data
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_sendBuffer.assign(data.data(), data.size());
+        SendFrameLocked(0xA);
     }
-    return totalRead == n;
 }
 
 void WebSocketClient::WorkerThread()
@@ -199,6 +187,12 @@ void WebSocketClient::WorkerThread()
             continue;
         }
 
+        // Non-blocking from here on; every read waits on WSAPoll readiness
+        u_long mode = 1;
+        ioctlsocket(m_socket, FIONBIO, &mode);
+
+        m_reader.Reset(m_socket, (size_t)(std::max)(g_config.Data().maxMessageSizeKB, 64) * 1024);
+
         std::string wsKey = GenerateWebSocketKey();
         std::ostringstream request;
         request << "GET / HTTP/1.1\r\n"
@@ -210,7 +204,8 @@ void WebSocketClient::WorkerThread()
             << "\r\n";
 
         std::string reqStr = request.str();
-        if (send(m_socket, reqStr.c_str(), (int)reqStr.size(), 0) == SOCKET_ERROR)
+        SocketIo::SendBuffer requestBuffer = { reqStr.data(), reqStr.size() };
+        if (SocketIo::SendAll(m_socket, &requestBuffer, 1, SEND_TIMEOUT_MS) != SocketIo::Status::Ready)
         {
             closesocket(m_socket);
             m_socket = INVALID_SOCKET;
@@ -218,9 +213,8 @@ void WebSocketClient::WorkerThread()
             continue;
         }
 
-        char buffer[1024];
-        int received = recv(m_socket, buffer, sizeof(buffer) - 1, 0);
-        if (received <= 0)
+        std::string response;
+        if (!m_reader.ReadHandshakeResponse(response))
         {
             closesocket(m_socket);
             m_socket = INVALID_SOCKET;
@@ -228,9 +222,6 @@ void WebSocketClient::WorkerThread()
             continue;
         }
 
-        buffer[received] = '\0';
-        std::string response(buffer);
-
         if (response.find("101") == std::string::npos)
         {
             closesocket(m_socket);
@@ -242,157 +233,17 @@ void WebSocketClient::WorkerThread()
         m_connected = true;
         OutputDebugStringW(L"[SPlayerLyric] Connected to SPlayer\n");
         {
-            std::lock_guard<std::mutex> lock(m_callbackMutex);
-            if (m_callbacks.onConnected)
-                m_callbacks.onConnected();
+            auto callbacks = LoadCallbacks();
+            if (callbacks && callbacks->onConnected)
+                callbacks->onConnected();
         }
 
-        // Set non-blocking with timeout
-        u_long mode = 1;
-        ioctlsocket(m_socket, FIONBIO, &mode);
-
-        std::string msgAccumulator;
-
-        while (m_running && m_connected)
+        WebSocketReader::End end = m_reader.Run([this](FrameDecoder::Event event, std::string_view data)
         {
-            // Read WebSocket frame header (2 bytes minimum)
-            unsigned char header[2];
-            
-            int result = recv(m_socket, (char*)header, 2, MSG_PEEK);
-            if (result < 2)
-            {
-                if (result == 0)
-                {
-                    m_connected = false;
-                    break;
-                }
-                int err = WSAGetLastError();
-                if (err == WSAEWOULDBLOCK)
-                {
-                    Sleep(50);
-                    continue;
-                }
-                m_connected = false;
-                break;
-            }
-
-            // Now read the full header
-            recv(m_socket, (char*)header, 2, 0);
-
-            bool fin = (header[0] & 0x80) != 0;
-            int opcode = header[0] & 0x0F;
-            bool masked = (header[1] & 0x80) != 0;
-            uint64_t payloadLen = header[1] & 0x7F;
-
-            // Read extended length if needed
-            if (payloadLen == 126)
-            {
-                unsigned char extLen[2];
-                if (!ReadBytes((char*)extLen, 2))
-                {
-                    m_connected = false;
-                    break;
-                }
-                payloadLen = (extLen[0] << 8) | extLen[1];
-            }
-            else if (payloadLen == 127)
-            {
-                unsigned char extLen[8];
-                if (!ReadBytes((char*)extLen, 8))
-                {
-                    m_connected = false;
-                    break;
-                }
-                payloadLen = 0;
-                for (int i = 0; i < 8; i++)
-                    payloadLen = (payloadLen << 8) | extLen[i];
-            }
-
-            // Read mask key if present (should not be for server->client)
-            unsigned char maskKey[4] = { 0 };
-            if (masked)
-            {
-                if (!ReadBytes((char*)maskKey, 4))
-                {
-                    m_connected = false;
-                    break;
-                }
-            }
-
-            // Read payload
-            std::string payload;
-            if (payloadLen > 0)
-            {
-                payload.resize(payloadLen);
-                size_t totalRead = 0;
-                while (totalRead < payloadLen && m_running && m_connected)
-                {
-                    int toRead = (int)min(payloadLen - totalRead, (uint64_t)8192);
-                    int r = recv(m_socket, &payload[totalRead], toRead, 0);
-                    if (r > 0)
-                    {
-                        totalRead += r;
-                    }
-                    else if (r == 0)
-                    {
-                        m_connected = false;
-                        break;
-                    }
-                    else
-                    {
-                        int err = WSAGetLastError();
-                        if (err == WSAEWOULDBLOCK)
-                        {
-                            Sleep(10);
-                            continue;
-                        }
-                        m_connected = false;
-                        break;
-                    }
-                }
-
-                if (totalRead < payloadLen)
-                    break;
-
-                // Unmask if needed
-                if (masked)
-                {
-                    for (size_t i = 0; i < payloadLen; i++)
-                        payload[i] ^= maskKey[i % 4];
-                }
-            }
-
-            // Handle frame
-            if (opcode == 0x1)  // Text frame
-            {
-                msgAccumulator = payload;
-                if (fin)
-                {
-                    ParseMessage(msgAccumulator);
-                    msgAccumulator.clear();
-                }
-            }
-            else if (opcode == 0x0)  // Continuation frame
-            {
-                msgAccumulator += payload;
-                if (fin)
-                {
-                    ParseMessage(msgAccumulator);
-                    msgAccumulator.clear();
-                }
-            }
-            else if (opcode == 0x8)  // Close
-            {
-                m_connected = false;
-                break;
-            }
-            else if (opcode == 0x9)  // Ping
-            {
-                unsigned char pong[2] = { 0x8A, 0x00 };
-                send(m_socket, (char*)pong, 2, 0);
-            }
-            // Ignore other opcodes
-        }
+            OnFrame(event, data);
+        });
+        if (end == WebSocketReader::End::ProtocolError)
+            OutputDebugStringW(L"[SPlayerLyric] WebSocket protocol error\n");
 
         closesocket(m_socket);
         m_socket = INVALID_SOCKET;
@@ -400,9 +251,9 @@ void WebSocketClient::WorkerThread()
         OutputDebugStringW(L"[SPlayerLyric] Disconnected from SPlayer\n");
 
         {
-            std::lock_guard<std::mutex> lock(m_callbackMutex);
-            if (m_callbacks.onDisconnected)
-                m_callbacks.onDisconnected();
+            auto callbacks = LoadCallbacks();
+            if (callbacks && callbacks->onDisconnected)
+                callbacks->onDisconnected();
         }
 
         if (m_running)
@@ -410,222 +261,122 @@ void WebSocketClient::WorkerThread()
     }
 }
 
-bool WebSocketClient::SendMessage(const std::string& msg)
+// xorshift64*: cheap and seeded once per client. Mask keys only need to be
+// unpredictable to intermediaries, not cryptographically strong.
+uint32_t WebSocketClient::NextMaskKey()
 {
-    std::lock_guard<std::mutex> lock(m_sendMutex);
+    m_maskState ^= m_maskState >> 12;
+    m_maskState ^= m_maskState << 25;
+    m_maskState ^= m_maskState >> 27;
+    return static_cast<uint32_t>((m_maskState * 0x2545F4914F6CDD1Dull) >> 32);
+}
 
+// Send m_sendBuffer as one masked frame. The caller holds m_sendMutex.
+// The payload is masked in place and written together with the header in
+// gather writes, so no frame buffer is assembled. The socket is non-blocking:
+// short writes continue with the rest, and a full send buffer is waited out.
+bool WebSocketClient::SendFrameLocked(unsigned char opcode)
+{
     if (!m_connected || m_socket == INVALID_SOCKET)
         return false;
 
-    std::vector<unsigned char> frame;
-
-    frame.push_back(0x81);
+    size_t len = m_sendBuffer.size();
+    unsigned char header[14];
+    size_t headerLen = 2;
 
-    size_t len = msg.size();
+    header[0] = static_cast<unsigned char>(0x80 | opcode);
     if (len < 126)
     {
-        frame.push_back(static_cast<unsigned char>(0x80 | len));
+        header[1] = static_cast<unsigned char>(0x80 | len);
     }
     else if (len < 65536)
     {
-        frame.push_back(0xFE);
-        frame.push_back(static_cast<unsigned char>((len >> 8) & 0xFF));
-        frame.push_back(static_cast<unsigned char>(len & 0xFF));
+        header[1] = 0xFE;
+        header[2] = static_cast<unsigned char>((len >> 8) & 0xFF);
+        header[3] = static_cast<unsigned char>(len & 0xFF);
+        headerLen += 2;
     }
     else
     {
-        frame.push_back(0xFF);
-        for (int i = 7; i >= 0; i--)
-            frame.push_back(static_cast<unsigned char>((len >> (i * 8)) & 0xFF));
+        header[1] = 0xFF;
+        for (int i = 0; i < 8; i++)
+            header[2 + i] = static_cast<unsigned char>(((uint64_t)len >> ((7 - i) * 8)) & 0xFF);
+        headerLen += 8;
     }
 
-    unsigned char mask[4];
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 255);
-    for (int i = 0; i < 4; i++)
-        mask[i] = static_cast<unsigned char>(dis(gen));
-
-    frame.insert(frame.end(), mask, mask + 4);
-
-    for (size_t i = 0; i < len; i++)
-        frame.push_back(msg[i] ^ mask[i % 4]);
-
-    int sent = send(m_socket, (char*)frame.data(), (int)frame.size(), 0);
-    return sent == (int)frame.size();
+    uint32_t key = NextMaskKey();
+    unsigned char* mask = header + headerLen;
+    memcpy(mask, &key, 4);
+    headerLen += 4;
+
+    unsigned char* payload = reinterpret_cast<unsigned char*>(m_sendBuffer.data());
+    ApplyWebSocketMask(payload, payload, len, mask);
+
+    SocketIo::SendBuffer buffers[2] = {
+        { reinterpret_cast<const char*>(header), headerLen },
+        { m_sendBuffer.data(), len },
+    };
+    if (SocketIo::SendAll(m_socket, buffers, 2, SEND_TIMEOUT_MS) == SocketIo::Status::Ready)
+        return true;
+
+    // Part of the frame may be out already, so the stream cannot be resumed.
+    // Shutting it down makes the worker notice and reconnect.
+    OutputDebugStringW(L"[SPlayerLyric] WebSocket send failed\n");
+    shutdown(m_socket, SD_BOTH);
+    return false;
 }
 
-void WebSocketClient::ParseMessage(const std::string& message)
+void WebSocketClient::ParseMessage(std::string_view message)
 {
-    try
+    // One SAX pass for every message type, no DOM. lyric-change is by far
+    // the largest and is decoded straight into the lyric timelines.
+    MessageParser::Message msg;
+    if (!MessageParser::Parse(message, msg))
     {
-        json j = json::parse(message);
-        
-        std::string type = j.value("type", "");
-        
-        OutputDebugStringA("[SPlayerLyric] Message type: ");
-        OutputDebugStringA(type.c_str());
-        OutputDebugStringA("\n");
-
-        auto msgType = SPlayerProtocol::ParseMessageType(type);
-
-        std::lock_guard<std::mutex> lock(m_callbackMutex);
-
-        switch (msgType)
-        {
-        case SPlayerProtocol::MessageType::StatusChange:
-        {
-            if (m_callbacks.onStatusChange)
-            {
-                bool isPlaying = j["data"].value("status", false);
-                m_callbacks.onStatusChange(isPlaying);
-            }
-            break;
-        }
-
-        case SPlayerProtocol::MessageType::SongChange:
-        {
-            if (m_callbacks.onSongChange)
-            {
-                SPlayerProtocol::SongInfo info;
-                auto& data = j["data"];
-                info.title = Utf8ToWideLocal(data.value("title", ""));
-                info.name = Utf8ToWideLocal(data.value("name", ""));
-                info.artist = Utf8ToWideLocal(data.value("artist", ""));
-                info.album = Utf8ToWideLocal(data.value("album", ""));
-                info.duration = data.value("duration", 0);
-                m_callbacks.onSongChange(info);
-            }
-            break;
-        }
+        OutputDebugStringW(L"[SPlayerLyric] JSON parse error\n");
+        return;
+    }
 
-        case SPlayerProtocol::MessageType::ProgressChange:
-        {
-            if (m_callbacks.onProgressChange)
-            {
-                SPlayerProtocol::ProgressInfo info;
-                auto& data = j["data"];
-                info.currentTime = data.value("currentTime", 0);
-                info.duration = data.value("duration", 0);
-                m_callbacks.onProgressChange(info);
-            }
-            break;
-        }
+    auto callbacks = LoadCallbacks();
+    if (!callbacks)
+        return;
 
-        case SPlayerProtocol::MessageType::LyricChange:
-        {
-            if (m_callbacks.onLyricChange)
-            {
-                SPlayerProtocol::LyricData lyricData;
-                auto& data = j["data"];
-
-                OutputDebugStringW(L"[SPlayerLyric] Processing lyric-change\n");
-
-                // Parse lrcData - SPlayer format has words array inside each line
-                if (data.contains("lrcData") && data["lrcData"].is_array())
-                {
-                    for (auto& item : data["lrcData"])
-                    {
-                        SPlayerProtocol::LrcLine line;
-                        line.time = item.value("startTime", (int64_t)0);
-                        
-                        // Get translation from translatedLyric field
-                        std::string transText = item.value("translatedLyric", "");
-                        if (!transText.empty())
-                            line.translation = Utf8ToWideLocal(transText);
-                        
-                        // Get text from words array
-                        if (item.contains("words") && item["words"].is_array() && !item["words"].empty())
-                        {
-                            std::wstring combined;
-                            for (auto& wordItem : item["words"])
-                            {
-                                std::string word = wordItem.value("word", "");
-                                if (!word.empty())
-                                    combined += Utf8ToWideLocal(word);
-                            }
-                            line.text = combined;
-                        }
-                        
-                        if (!line.text.empty())
-                            lyricData.lrcData.push_back(line);
-                    }
-                }
-
-                // Parse yrcData - similar structure
-                if (data.contains("yrcData") && data["yrcData"].is_array())
-                {
-                    for (auto& item : data["yrcData"])
-                    {
-                        SPlayerProtocol::YrcLine line;
-                        line.startTime = item.value("startTime", (int64_t)0);
-                        line.endTime = item.value("endTime", (int64_t)0);
-                        
-                        // Get translation from translatedLyric field
-                        std::string transText = item.value("translatedLyric", "");
-                        if (!transText.empty())
-                            line.translation = Utf8ToWideLocal(transText);
-
-                        if (item.contains("words") && item["words"].is_array())
-                        {
-                            for (auto& wordItem : item["words"])
-                            {
-                                SPlayerProtocol::YrcWord word;
-                                word.startTime = wordItem.value("startTime", (int64_t)0);
-                                int64_t endTime = wordItem.value("endTime", (int64_t)0);
-                                word.duration = endTime - word.startTime;
-                                word.text = Utf8ToWideLocal(wordItem.value("word", ""));
-                                if (!word.text.empty())
-                                    line.words.push_back(word);
-                            }
-                        }
-
-                        if (!line.words.empty())
-                            lyricData.yrcData.push_back(line);
-                    }
-                }
-
-                // Parse transData
-                if (data.contains("transData") && data["transData"].is_array())
-                {
-                    for (auto& item : data["transData"])
-                    {
-                        SPlayerProtocol::LrcLine line;
-                        line.time = item.value("startTime", (int64_t)0);
-                        line.text = Utf8ToWideLocal(item.value("word", ""));
-                        if (!line.text.empty())
-                            lyricData.transData.push_back(line);
-                    }
-                }
-
-                wchar_t buf[128];
-                swprintf_s(buf, L"[SPlayerLyric] Parsed LRC=%zu, YRC=%zu, TRANS=%zu\n",
-                    lyricData.lrcData.size(), lyricData.yrcData.size(), lyricData.transData.size());
-                OutputDebugStringW(buf);
-
-                m_callbacks.onLyricChange(lyricData);
-            }
-            break;
-        }
+    switch (msg.type)
+    {
+    case SPlayerProtocol::MessageType::StatusChange:
+        if (callbacks->onStatusChange)
+            callbacks->onStatusChange(msg.isPlaying);
+        break;
+
+    case SPlayerProtocol::MessageType::SongChange:
+        if (callbacks->onSongChange)
+            callbacks->onSongChange(msg.song);
+        break;
+
+    case SPlayerProtocol::MessageType::ProgressChange:
+        if (callbacks->onProgressChange)
+            callbacks->onProgressChange(msg.progress);
+        break;
+
+    case SPlayerProtocol::MessageType::LyricChange:
+    {
+        wchar_t buf[128];
+        swprintf_s(buf, L"[SPlayerLyric] Parsed LRC=%zu, YRC=%zu, TRANS=%zu\n",
+            msg.lyrics.lrcData.LineCount(), msg.lyrics.yrcData.LineCount(), msg.lyrics.transData.LineCount());
+        OutputDebugStringW(buf);
+
+        // Ownership moves on to the callback, the timelines are never copied
+        if (callbacks->onLyricChange)
+            callbacks->onLyricChange(std::move(msg.lyrics));
+        break;
+    }
 
-        case SPlayerProtocol::MessageType::Error:
-        {
-            if (m_callbacks.onError)
-            {
-                std::string errorMsg = j["data"].value("message", "Unknown error");
-                m_callbacks.onError(errorMsg);
-            }
-            break;
-        }
+    case SPlayerProtocol::MessageType::Error:
+        if (callbacks->onError)
+            callbacks->onError(msg.error);
+        break;
 
-        default:
-            break;
-        }
-    }
-    catch (const std::exception& e)
-    {
-        OutputDebugStringA("[SPlayerLyric] JSON parse error: ");
-        OutputDebugStringA(e.what());
-        OutputDebugStringA("\n");
+    default:
+        break;
     }
 }
@@ -7,9 +7,11 @@
 #pragma once
 
 #include "SPlayerProtocol.h"
+#include "WebSocketReader.h"
 #include <functional>
 #include <thread>
 #include <atomic>
+#include <memory>
 #include <mutex>
 
 struct WebSocketCallbacks
@@ -19,7 +21,7 @@ struct WebSocketCallbacks
     std::function<void(bool isPlaying)> onStatusChange;
     std::function<void(const SPlayerProtocol::SongInfo&)> onSongChange;
     std::function<void(const SPlayerProtocol::ProgressInfo&)> onProgressChange;
-    std::function<void(const SPlayerProtocol::LyricData&)> onLyricChange;
+    std::function<void(SPlayerProtocol::LyricData&&)> onLyricChange;   // Owns the parsed lyrics
     std::function<void(const std::string&)> onError;
 };
 
@@ -41,9 +43,12 @@ private:
     ~WebSocketClient();
 
     void WorkerThread();
-    void ParseMessage(const std::string& message);
-    bool SendMessage(const std::string& msg);
-    bool ReadBytes(char* buffer, size_t n);
+    void ParseMessage(std::string_view message);
+    bool SendFrameLocked(unsigned char opcode);
+    uint32_t NextMaskKey();
+    void OnFrame(FrameDecoder::Event event, std::string_view data);
+
+    std::shared_ptr<const WebSocketCallbacks> LoadCallbacks() const { return std::atomic_load(&m_callbacks); }
 
     std::thread m_workerThread;
     std::atomic<bool> m_running{ false };
@@ -52,10 +57,14 @@ private:
     int m_port = 25885;
     SOCKET m_socket = INVALID_SOCKET;
 
-    std::mutex m_callbackMutex;
-    WebSocketCallbacks m_callbacks;
+    WebSocketReader m_reader{ m_running };
+
+    // Replaced as a whole by SetCallbacks; the worker loads it without locking
+    std::shared_ptr<const WebSocketCallbacks> m_callbacks;
 
     std::mutex m_sendMutex;
+    std::string m_sendBuffer;       // Reused outbound payload, guarded by m_sendMutex
+    uint64_t m_maskState = 0;       // xorshift state for frame mask keys
 };
 
 #define g_wsClient WebSocketClient::Instance()
@@ -0,0 +1,194 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * WebSocket Payload Masking Implementation
+ */
+
+#include "pch.h"
+#include "WebSocketMask.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define WS_MASK_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+// MSVC allows AVX2 intrinsics without /arch:AVX2, so pick the path at runtime
+#define WS_MASK_AVX2 1
+#define WS_MASK_AVX2_TARGET
+#include <immintrin.h>
+#include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+// GCC and Clang build just the AVX2 kernel for AVX2, also picked at runtime
+#define WS_MASK_AVX2 1
+#define WS_MASK_AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+#if defined(_M_ARM64) || defined(__ARM_NEON)
+#define WS_MASK_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Each kernel masks whole blocks from the start and returns how many bytes
+// it did. The key repeats every 4 bytes and every block size is a multiple
+// of 4, so a block-wide copy of the key stays in phase across blocks.
+
+#ifdef WS_MASK_AVX2
+static bool DetectAvx2()
+{
+#ifdef _MSC_VER
+    int info[4] = { 0 };
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // OS must save YMM state (OSXSAVE + XCR0 bits 1 and 2)
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0)
+        return false;
+    if ((_xgetbv(0) & 0x6) != 0x6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static bool HasAvx2()
+{
+    static const bool hasAvx2 = DetectAvx2();
+    return hasAvx2;
+}
+
+WS_MASK_AVX2_TARGET
+static size_t MaskAvx2(unsigned char* dst, const unsigned char* src, size_t len, uint32_t key32)
+{
+    const __m256i key = _mm256_set1_epi32((int)key32);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_xor_si256(v, key));
+    }
+    return i;
+}
+#endif
+
+#ifdef WS_MASK_SSE2
+static size_t MaskSse2(unsigned char* dst, const unsigned char* src, size_t len, uint32_t key32)
+{
+    const __m128i key = _mm_set1_epi32((int)key32);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_xor_si128(v, key));
+    }
+    return i;
+}
+#endif
+
+#ifdef WS_MASK_NEON
+static size_t MaskNeon(unsigned char* dst, const unsigned char* src, size_t len, uint32_t key32)
+{
+    const uint8x16_t key = vreinterpretq_u8_u32(vdupq_n_u32(key32));
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+        vst1q_u8(dst + i, veorq_u8(vld1q_u8(src + i), key));
+    return i;
+}
+#endif
+
+// Word-at-a-time from i to the end, for whatever the vector kernels left over
+static void MaskWords(unsigned char* dst, const unsigned char* src, size_t i, size_t len, uint32_t key32, const unsigned char key[4])
+{
+    const uint64_t key64 = ((uint64_t)key32 << 32) | key32;
+    for (; i + 8 <= len; i += 8)
+    {
+        uint64_t v;
+        memcpy(&v, src + i, 8);
+        v ^= key64;
+        memcpy(dst + i, &v, 8);
+    }
+
+    for (; i < len; i++)
+        dst[i] = src[i] ^ key[i & 3];
+}
+
+void ApplyWebSocketMask(unsigned char* dst, const unsigned char* src, size_t len, const unsigned char key[4])
+{
+    uint32_t key32;
+    memcpy(&key32, key, 4);
+    size_t i = 0;
+
+#ifdef WS_MASK_AVX2
+    if (len >= 32 && HasAvx2())
+        i = MaskAvx2(dst, src, len, key32);
+#endif
+
+#if defined(WS_MASK_SSE2)
+    i += MaskSse2(dst + i, src + i, len - i, key32);
+#elif defined(WS_MASK_NEON)
+    i += MaskNeon(dst + i, src + i, len - i, key32);
+#endif
+
+    MaskWords(dst, src, i, len, key32, key);
+}
+
+bool WebSocketMaskKernelAvailable(WebSocketMaskKernel kernel)
+{
+    switch (kernel)
+    {
+    case WebSocketMaskKernel::Word:
+        return true;
+#ifdef WS_MASK_SSE2
+    case WebSocketMaskKernel::Sse2:
+        return true;
+#endif
+#ifdef WS_MASK_AVX2
+    case WebSocketMaskKernel::Avx2:
+        return HasAvx2();
+#endif
+#ifdef WS_MASK_NEON
+    case WebSocketMaskKernel::Neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+void ApplyWebSocketMaskWith(WebSocketMaskKernel kernel, unsigned char* dst, const unsigned char* src, size_t len, const unsigned char key[4])
+{
+    uint32_t key32;
+    memcpy(&key32, key, 4);
+    size_t i = 0;
+
+    switch (kernel)
+    {
+#ifdef WS_MASK_SSE2
+    case WebSocketMaskKernel::Sse2:
+        i = MaskSse2(dst, src, len, key32);
+        break;
+#endif
+#ifdef WS_MASK_AVX2
+    case WebSocketMaskKernel::Avx2:
+        i = MaskAvx2(dst, src, len, key32);
+        break;
+#endif
+#ifdef WS_MASK_NEON
+    case WebSocketMaskKernel::Neon:
+        i = MaskNeon(dst, src, len, key32);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    MaskWords(dst, src, i, len, key32, key);
+}
@@ -0,0 +1,31 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * WebSocket Payload Masking
+ */
+
+#pragma once
+
+#include <cstddef>
+
+// XOR len bytes of src with the repeating 4-byte mask key and write them to dst.
+// dst may equal src for in-place unmasking; the mask phase starts at key[0].
+// Uses AVX2/SSE2/NEON where available and a word-at-a-time scalar path otherwise.
+void ApplyWebSocketMask(unsigned char* dst, const unsigned char* src, size_t len, const unsigned char key[4]);
+
+// The kernels ApplyWebSocketMask picks from, selectable one by one so the
+// tests and the benchmark can cover each of them on the machine they run on
+enum class WebSocketMaskKernel
+{
+    Word,   // 8 bytes at a time, any CPU
+    Sse2,
+    Avx2,
+    Neon,
+};
+
+// Whether the kernel is compiled in and the CPU can run it
+bool WebSocketMaskKernelAvailable(WebSocketMaskKernel kernel);
+
+// ApplyWebSocketMask through one kernel (and the word path for the tail).
+// The kernel must be available.
+void ApplyWebSocketMaskWith(WebSocketMaskKernel kernel, unsigned char* dst, const unsigned char* src, size_t len, const unsigned char key[4]);
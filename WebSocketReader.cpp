@@ -0,0 +1,111 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * WebSocket Receive Loop Implementation
+ */
+
+#include "pch.h"
+#include "WebSocketReader.h"
+
+void WebSocketReader::Reset(SocketHandle socket, size_t maxMessageSize)
+{
+    m_socket = socket;
+    m_decoder.Reset();
+    m_decoder.SetMaxMessageSize(maxMessageSize);
+}
+
+// Block until the socket has data (or the connection goes away).
+// The timeout only bounds how long a stop may wait; data wakes us immediately.
+bool WebSocketReader::WaitReadable()
+{
+    while (m_running)
+    {
+        switch (SocketIo::WaitReadable(m_socket, POLL_TIMEOUT_MS))
+        {
+        case SocketIo::Status::Ready:
+            return true;
+        case SocketIo::Status::Timeout:
+            break;
+        default:
+            return false;
+        }
+    }
+    return false;
+}
+
+// Receive whatever the socket has straight into the frame decoder
+bool WebSocketReader::ReceiveMore()
+{
+    while (m_running)
+    {
+        size_t space = 0;
+        char* dst = m_decoder.PrepareWrite(space);
+        size_t received = 0;
+        switch (SocketIo::Receive(m_socket, dst, space, received))
+        {
+        case SocketIo::Status::Ready:
+            m_decoder.Commit(received);
+            return true;
+        case SocketIo::Status::WouldBlock:
+            if (!WaitReadable())
+                return false;
+            break;
+        default:
+            return false;   // Closed or failed
+        }
+    }
+    return false;
+}
+
+bool WebSocketReader::ReadHandshakeResponse(std::string& response)
+{
+    while (true)
+    {
+        std::string_view pending = m_decoder.Pending();
+        size_t end = pending.find("\r\n\r\n");
+        if (end != std::string_view::npos)
+        {
+            response.assign(pending.data(), end + 4);
+            m_decoder.Consume(end + 4);
+            return true;
+        }
+
+        if (pending.size() > MAX_HANDSHAKE_SIZE)
+            return false;
+
+        if (!ReceiveMore())
+            return false;
+    }
+}
+
+WebSocketReader::End WebSocketReader::Run(const FrameHandler& onFrame)
+{
+    std::string_view data;
+    while (m_running)
+    {
+        // Frames already buffered (e.g. sent along with the handshake) go first
+        switch (m_decoder.Next(data))
+        {
+        case FrameDecoder::Event::NeedMore:
+            if (!ReceiveMore())
+                return m_running ? End::Disconnected : End::Stopped;
+            break;
+
+        case FrameDecoder::Event::Text:
+            onFrame(FrameDecoder::Event::Text, data);
+            break;
+
+        case FrameDecoder::Event::Ping:
+            onFrame(FrameDecoder::Event::Ping, data);
+            break;
+
+        case FrameDecoder::Event::Close:
+            return End::CloseFrame;
+
+        case FrameDecoder::Event::Error:
+        default:
+            return End::ProtocolError;
+        }
+    }
+    return End::Stopped;
+}
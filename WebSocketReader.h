@@ -0,0 +1,61 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * WebSocket Receive Loop
+ */
+
+#pragma once
+
+#include "FrameDecoder.h"
+#include "SocketIo.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// The receive half of the client's connection: reads a non-blocking socket
+// into a FrameDecoder as soon as it is readable and hands every complete
+// frame to a handler, with no sleeps in between. Platform-neutral, so the
+// path from socket to message callback runs in the Linux tests as well.
+class WebSocketReader
+{
+public:
+    // Text and Ping frames with their payload. The view is only valid until
+    // the handler returns.
+    using FrameHandler = std::function<void(FrameDecoder::Event event, std::string_view data)>;
+
+    // Why Run() returned
+    enum class End
+    {
+        Stopped,        // running went false
+        Disconnected,   // The socket closed or failed
+        CloseFrame,     // The server sent a close frame
+        ProtocolError,  // The server broke the framing rules
+    };
+
+    // running is checked between waits; clearing it ends Run() within one
+    // poll timeout
+    explicit WebSocketReader(const std::atomic<bool>& running) : m_running(running) {}
+
+    // Start on a freshly connected socket, dropping anything buffered
+    void Reset(SocketHandle socket, size_t maxMessageSize);
+
+    // Read the HTTP upgrade response up to the blank line. Any frame bytes
+    // the server sent right behind it stay buffered for Run().
+    bool ReadHandshakeResponse(std::string& response);
+
+    // Dispatch frames as they arrive until the connection ends
+    End Run(const FrameHandler& onFrame);
+
+private:
+    bool WaitReadable();
+    bool ReceiveMore();
+
+    // Upper bound on a single poll wait, only affects how quickly a stop is noticed
+    static const int POLL_TIMEOUT_MS = 250;
+    static const size_t MAX_HANDSHAKE_SIZE = 16 * 1024;
+
+    const std::atomic<bool>& m_running;
+    SocketHandle m_socket = (SocketHandle)-1;
+    FrameDecoder m_decoder;
+};
@@ -4,8 +4,12 @@
 #ifndef PCH_H
 #define PCH_H
 
+// The platform-neutral modules are also built on their own by the unit
+// tests (CMakeLists.txt), where only the standard library is available
+#ifdef _WIN32
 #include "framework.h"
 #include "resource.h"
+#endif
 
 // STL
 #include <string>
@@ -17,8 +21,10 @@
 #include <functional>
 
 // Windows Socket
+#ifdef _WIN32
 #include <WinSock2.h>
 #include <WS2tcpip.h>
 #pragma comment(lib, "ws2_32.lib")
+#endif
 
 #endif //PCH_H
@@ -0,0 +1,121 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Counting Global Allocator for Tests and Benchmarks
+ */
+
+#pragma once
+
+// Replaces the global operator new/delete with versions that count calls
+// and track live and peak heap bytes. Include it in exactly one source file
+// of a test program. Over-aligned allocations are not counted.
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace CountingAllocator
+{
+    struct Counters
+    {
+        uint64_t allocations = 0;   // operator new calls
+        uint64_t bytes = 0;         // Bytes requested by them
+        int64_t live = 0;           // Bytes allocated and not yet freed
+        int64_t peak = 0;           // Highest live since the last Reset()
+    };
+
+    namespace Detail
+    {
+        inline std::atomic<uint64_t> allocations{ 0 };
+        inline std::atomic<uint64_t> bytes{ 0 };
+        inline std::atomic<int64_t> live{ 0 };
+        inline std::atomic<int64_t> peak{ 0 };
+
+        // The size sits in front of the block so delete knows what it frees
+        const size_t HEADER = 16;
+
+        inline void* Allocate(size_t size) noexcept
+        {
+            void* block = std::malloc(size + HEADER);
+            if (!block)
+                return nullptr;
+            *static_cast<size_t*>(block) = size;
+
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            bytes.fetch_add(size, std::memory_order_relaxed);
+            int64_t now = live.fetch_add((int64_t)size, std::memory_order_relaxed) + (int64_t)size;
+            int64_t high = peak.load(std::memory_order_relaxed);
+            while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed))
+            {
+            }
+            return static_cast<char*>(block) + HEADER;
+        }
+
+        // GCC sees free() reached from operator delete and takes it for a
+        // mismatched pair; the block did come from malloc in Allocate
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+        inline void Free(void* p) noexcept
+        {
+            if (!p)
+                return;
+            void* block = static_cast<char*>(p) - HEADER;
+            live.fetch_sub((int64_t)*static_cast<size_t*>(block), std::memory_order_relaxed);
+            std::free(block);
+        }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+    }
+
+    inline Counters Get()
+    {
+        Counters counters;
+        counters.allocations = Detail::allocations.load(std::memory_order_relaxed);
+        counters.bytes = Detail::bytes.load(std::memory_order_relaxed);
+        counters.live = Detail::live.load(std::memory_order_relaxed);
+        counters.peak = Detail::peak.load(std::memory_order_relaxed);
+        return counters;
+    }
+
+    // Start counting afresh; the peak restarts from what is live now
+    inline void Reset()
+    {
+        Detail::allocations.store(0, std::memory_order_relaxed);
+        Detail::bytes.store(0, std::memory_order_relaxed);
+        Detail::peak.store(Detail::live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void* operator new(size_t size)
+{
+    void* p = CountingAllocator::Detail::Allocate(size);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return CountingAllocator::Detail::Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return CountingAllocator::Detail::Allocate(size);
+}
+
+void operator delete(void* p) noexcept { CountingAllocator::Detail::Free(p); }
+void operator delete[](void* p) noexcept { CountingAllocator::Detail::Free(p); }
+void operator delete(void* p, size_t) noexcept { CountingAllocator::Detail::Free(p); }
+void operator delete[](void* p, size_t) noexcept { CountingAllocator::Detail::Free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { CountingAllocator::Detail::Free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { CountingAllocator::Detail::Free(p); }
@@ -0,0 +1,47 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Fake Text Measurer for Tests
+ */
+
+#pragma once
+
+#include "TextMeasurer.h"
+#include <string>
+#include <vector>
+
+// Monospaced stand-in for GDI: every character is charWidth wide and a line
+// is the font height tall. Records each string it was asked to measure.
+class FakeTextMeasurer : public ITextMeasurer
+{
+public:
+    explicit FakeTextMeasurer(int charWidth = 10, int height = 20)
+    {
+        SetFont(charWidth, height);
+    }
+
+    void SetFont(int charWidth, int height)
+    {
+        m_charWidth = charWidth;
+        m_height = height;
+        m_fontId = MakeFontId(L"Fake", height, charWidth);
+    }
+
+    TextExtent Measure(std::wstring_view text) override
+    {
+        calls.emplace_back(text);
+        TextExtent extent;
+        extent.cx = (int)text.size() * m_charWidth;
+        extent.cy = m_height;
+        return extent;
+    }
+
+    uint64_t FontId() const override { return m_fontId; }
+
+    std::vector<std::wstring> calls;
+
+private:
+    int m_charWidth = 0;
+    int m_height = 0;
+    uint64_t m_fontId = 0;
+};
@@ -0,0 +1,127 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * FrameDecoder Throughput Benchmark
+ */
+
+#include "FrameDecoder.h"
+#include "LyricPayloads.h"
+#include "WebSocketFrames.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Progress-sized and lyric-sized messages, fed through the decoder the way
+// the receive loop does (up to 16 KB per recv)
+static double Run(size_t payloadSize, size_t frames, size_t recvSize)
+{
+    std::string payload(payloadSize, 'x');
+    std::string frame;
+    frame.push_back((char)0x81);
+    if (payloadSize < 126)
+    {
+        frame.push_back((char)payloadSize);
+    }
+    else
+    {
+        frame.push_back((char)127);
+        for (int i = 7; i >= 0; --i)
+            frame.push_back((char)((uint64_t)payloadSize >> (i * 8)));
+    }
+    frame += payload;
+
+    std::string stream;
+    for (size_t i = 0; i < frames; ++i)
+        stream += frame;
+
+    FrameDecoder decoder;
+    size_t messages = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < stream.size();)
+    {
+        size_t available = 0;
+        char* dst = decoder.PrepareWrite(available);
+        size_t n = std::min({ available, recvSize, stream.size() - pos });
+        memcpy(dst, stream.data() + pos, n);
+        decoder.Commit(n);
+        pos += n;
+
+        std::string_view data;
+        while (decoder.Next(data) == FrameDecoder::Event::Text)
+            ++messages;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%8zu-byte messages: %8.1f MB/s, %10.0f messages/s (%zu decoded)\n",
+        payloadSize, stream.size() / seconds / 1e6, messages / seconds, messages);
+    return seconds;
+}
+
+// A 2 MB lyric-change message split into fragments of fragmentSize, with
+// a ping after every 16th fragment, replayed messages times through 16 KB
+// reads. Reports the bytes the decoder copies per message on top of the
+// socket's own copy into its buffer.
+static void Replay(size_t fragmentSize, int messages)
+{
+    LyricPayloads::Shape shape;
+    shape.lines = 1550;
+    std::string message = LyricPayloads::MakeLyricChange(shape);
+
+    std::string stream;
+    for (size_t pos = 0, fragment = 0; pos < message.size(); pos += fragmentSize, ++fragment)
+    {
+        size_t n = (std::min)(fragmentSize, message.size() - pos);
+        stream += WebSocketFrames::MakeFrame(pos == 0 ? 0x1 : 0x0, pos + n == message.size(), message.substr(pos, n));
+        if (fragment % 16 == 15)
+            stream += WebSocketFrames::MakeFrame(0x9, true, "ping");
+    }
+
+    FrameDecoder decoder;
+    int decoded = 0;
+    bool intact = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < messages; ++i)
+    {
+        for (size_t pos = 0; pos < stream.size();)
+        {
+            size_t available = 0;
+            char* dst = decoder.PrepareWrite(available);
+            size_t n = std::min({ available, (size_t)16384, stream.size() - pos });
+            memcpy(dst, stream.data() + pos, n);
+            decoder.Commit(n);
+            pos += n;
+
+            std::string_view data;
+            FrameDecoder::Event event;
+            while ((event = decoder.Next(data)) != FrameDecoder::Event::NeedMore)
+            {
+                if (event == FrameDecoder::Event::Text)
+                {
+                    intact = intact && data.size() == message.size() && data.back() == message.back();
+                    ++decoded;
+                }
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double copied = (double)decoder.BytesCopied() / messages;
+    std::printf("%6zu-byte fragments: %8.0f bytes copied per %zu-byte message (%.2fx), %7.2f ms/message%s\n",
+        fragmentSize, copied, message.size(), copied / message.size(), seconds * 1000 / messages,
+        intact && decoded == messages ? "" : " MISMATCH");
+}
+
+int main()
+{
+    Run(80, 2000000, 16384);
+    Run(4096, 100000, 16384);
+    Run(200000, 2000, 16384);
+
+    Replay(4096, 50);
+    Replay(16384, 50);
+    Replay(65536, 50);
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * FrameDecoder Tests
+ */
+
+#include "TestCheck.h"
+#include "FrameDecoder.h"
+#include "WebSocketFrames.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using WebSocketFrames::MakeFrame;
+
+namespace
+{
+    struct Received
+    {
+        FrameDecoder::Event event;
+        std::string data;
+
+        bool operator==(const Received& other) const { return event == other.event && data == other.data; }
+    };
+
+    // Feed the stream in chunks of the given sizes (cycled) and collect every event
+    std::vector<Received> Feed(FrameDecoder& decoder, const std::string& stream, const std::vector<size_t>& chunks)
+    {
+        std::vector<Received> events;
+        size_t pos = 0;
+        size_t chunk = 0;
+        while (pos < stream.size())
+        {
+            size_t available = 0;
+            char* dst = decoder.PrepareWrite(available);
+            size_t n = (std::min)({ available, chunks[chunk++ % chunks.size()], stream.size() - pos });
+            memcpy(dst, stream.data() + pos, n);
+            decoder.Commit(n);
+            pos += n;
+
+            std::string_view data;
+            FrameDecoder::Event event;
+            while ((event = decoder.Next(data)) != FrameDecoder::Event::NeedMore)
+            {
+                events.push_back({ event, std::string(data) });
+                if (event == FrameDecoder::Event::Error)
+                    return events;
+            }
+        }
+        return events;
+    }
+
+    std::vector<Received> FeedAll(const std::string& stream, size_t maxMessageSize = 0)
+    {
+        FrameDecoder decoder;
+        if (maxMessageSize != 0)
+            decoder.SetMaxMessageSize(maxMessageSize);
+        return Feed(decoder, stream, { stream.size() });
+    }
+
+    std::string Pattern(size_t size, unsigned seed)
+    {
+        std::string s(size, '\0');
+        for (size_t i = 0; i < size; ++i)
+            s[i] = (char)('a' + (i * 7 + seed) % 26);
+        return s;
+    }
+}
+
+static void SingleTextFrame()
+{
+    auto events = FeedAll(MakeFrame(0x1, true, "{\"type\":\"ping\"}"));
+    CHECK_EQ(events.size(), 1u);
+    CHECK(events[0] == (Received{ FrameDecoder::Event::Text, "{\"type\":\"ping\"}" }));
+}
+
+static void ByteByByteSplits()
+{
+    std::string stream = MakeFrame(0x1, true, "first") + MakeFrame(0x9, true, "hb") +
+        MakeFrame(0x1, true, Pattern(300, 1)) + MakeFrame(0x8, true, "");
+
+    std::vector<Received> expected = {
+        { FrameDecoder::Event::Text, "first" },
+        { FrameDecoder::Event::Ping, "hb" },
+        { FrameDecoder::Event::Text, Pattern(300, 1) },
+        { FrameDecoder::Event::Close, "" },
+    };
+
+    FrameDecoder decoder;
+    CHECK(Feed(decoder, stream, { 1 }) == expected);
+
+    // Every split point of a two-part delivery
+    for (size_t split = 1; split < stream.size(); ++split)
+    {
+        FrameDecoder split2;
+        CHECK(Feed(split2, stream, { split, stream.size() }) == expected);
+    }
+}
+
+static void FragmentedWithInterleavedPings()
+{
+    std::string stream = MakeFrame(0x1, false, "Hel") + MakeFrame(0x9, true, "p1") +
+        MakeFrame(0x0, false, "lo ") + MakeFrame(0x9, true, "p2") +
+        MakeFrame(0x0, true, "World") + MakeFrame(0x1, true, "next");
+
+    std::vector<Received> expected = {
+        { FrameDecoder::Event::Ping, "p1" },
+        { FrameDecoder::Event::Ping, "p2" },
+        { FrameDecoder::Event::Text, "Hello World" },
+        { FrameDecoder::Event::Text, "next" },
+    };
+
+    FrameDecoder whole;
+    CHECK(Feed(whole, stream, { stream.size() }) == expected);
+    FrameDecoder bytes;
+    CHECK(Feed(bytes, stream, { 1 }) == expected);
+}
+
+// A message far larger than the initial buffer, in small fragments with
+// pings between them: it is reassembled inside the receive buffer, and the
+// oversized buffer is given back afterwards
+static void LargeFragmentedMessage()
+{
+    std::string message = Pattern(3 * 1024 * 1024, 5);
+    std::string stream;
+    for (size_t pos = 0; pos < message.size(); pos += 3000)
+    {
+        size_t n = (std::min)((size_t)3000, message.size() - pos);
+        stream += MakeFrame(pos == 0 ? 0x1 : 0x0, pos + n == message.size(), message.substr(pos, n));
+        if (pos % 30000 == 0)
+            stream += MakeFrame(0x9, true, "hb");
+    }
+    stream += MakeFrame(0x1, true, "next");
+
+    FrameDecoder decoder;
+    auto events = Feed(decoder, stream, { 16384, 1500, 70000 });
+    CHECK(!events.empty() && events.back() == (Received{ FrameDecoder::Event::Text, "next" }));
+    CHECK(events.size() >= 2 && events[events.size() - 2] == (Received{ FrameDecoder::Event::Text, message }));
+    // One move per continuation byte, plus the doubling from 64 KB up to a
+    // buffer that holds the whole message
+    CHECK(decoder.BytesCopied() < message.size() * 5 / 2);
+
+    // Still decodes normally once the large buffer has been dropped
+    CHECK(Feed(decoder, MakeFrame(0x1, true, "small"), { 64 }) == (std::vector<Received>{ { FrameDecoder::Event::Text, "small" } }));
+}
+
+static void FragmentedBinaryIsSkipped()
+{
+    std::string stream = MakeFrame(0x2, false, "\x01\x02") + MakeFrame(0x0, true, "\x03") + MakeFrame(0x1, true, "after");
+    auto events = FeedAll(stream);
+    CHECK_EQ(events.size(), 1u);
+    CHECK(events[0] == (Received{ FrameDecoder::Event::Text, "after" }));
+}
+
+static void MaskedFrames()
+{
+    std::string payload = Pattern(1000, 3);
+    std::string stream = MakeFrame(0x1, true, payload, true, 0xA1B2C3D4) + MakeFrame(0x9, true, "mp", true, 0x01020304);
+    auto events = FeedAll(stream);
+    CHECK_EQ(events.size(), 2u);
+    CHECK(events[0] == (Received{ FrameDecoder::Event::Text, payload }));
+    CHECK(events[1] == (Received{ FrameDecoder::Event::Ping, "mp" }));
+
+    // Masked frames split inside the key and the payload
+    FrameDecoder decoder;
+    CHECK(Feed(decoder, stream, { 3, 1, 7 }) == events);
+}
+
+static void ExtendedLengths()
+{
+    // 125 is the largest 7-bit length, 126..65535 use 16 bits, above that 64 bits
+    for (size_t size : { (size_t)125, (size_t)126, (size_t)65535, (size_t)65536, (size_t)200000 })
+    {
+        std::string payload = Pattern(size, (unsigned)size);
+        auto events = FeedAll(MakeFrame(0x1, true, payload));
+        CHECK_EQ(events.size(), 1u);
+        CHECK(!events.empty() && events[0].data == payload);
+    }
+}
+
+static void OversizeRejected()
+{
+    // MaxMessageSizeKB = 1
+    const size_t limit = 1024;
+
+    auto atLimit = FeedAll(MakeFrame(0x1, true, Pattern(limit, 0)), limit);
+    CHECK_EQ(atLimit.size(), 1u);
+    CHECK(!atLimit.empty() && atLimit[0].event == FrameDecoder::Event::Text);
+
+    // A single frame over the limit is rejected from its header alone
+    auto frame = FeedAll(MakeFrame(0x1, true, Pattern(limit + 1, 0)), limit);
+    CHECK_EQ(frame.size(), 1u);
+    CHECK(!frame.empty() && frame[0].event == FrameDecoder::Event::Error);
+
+    // So is a fragmented message whose fragments add up to more
+    std::string fragmented = MakeFrame(0x1, false, Pattern(600, 0)) + MakeFrame(0x0, true, Pattern(600, 1));
+    auto message = FeedAll(fragmented, limit);
+    CHECK_EQ(message.size(), 1u);
+    CHECK(!message.empty() && message[0].event == FrameDecoder::Event::Error);
+
+    // A 64-bit length far beyond the limit must not be allocated for
+    std::string huge = { (char)0x81, (char)127, 0, 0, 0, 1, 0, 0, 0, 0 };
+    auto lengthOnly = FeedAll(huge, limit);
+    CHECK_EQ(lengthOnly.size(), 1u);
+    CHECK(!lengthOnly.empty() && lengthOnly[0].event == FrameDecoder::Event::Error);
+}
+
+static void ProtocolErrors()
+{
+    auto orphan = FeedAll(MakeFrame(0x0, true, "x"));
+    CHECK(!orphan.empty() && orphan.back().event == FrameDecoder::Event::Error);
+
+    auto nested = FeedAll(MakeFrame(0x1, false, "a") + MakeFrame(0x1, true, "b"));
+    CHECK(!nested.empty() && nested.back().event == FrameDecoder::Event::Error);
+
+    auto fragmentedPing = FeedAll(MakeFrame(0x9, false, "p"));
+    CHECK(!fragmentedPing.empty() && fragmentedPing.back().event == FrameDecoder::Event::Error);
+}
+
+// Random messages cut into random fragments, with pings in between, delivered
+// in random chunk sizes; the decoder must reproduce exactly the messages sent
+static void RandomizedStreams()
+{
+    std::mt19937 rng(12345);
+    for (int round = 0; round < 200; ++round)
+    {
+        std::string stream;
+        std::vector<Received> expected;
+
+        int messages = 1 + rng() % 8;
+        for (int m = 0; m < messages; ++m)
+        {
+            size_t size = rng() % 4 == 0 ? rng() % 70000 : rng() % 300;
+            std::string payload = Pattern(size, rng());
+            bool masked = rng() % 3 == 0;
+            size_t pos = 0;
+            bool first = true;
+            do
+            {
+                size_t part = (std::min)(payload.size() - pos, (size_t)(rng() % 5 == 0 ? payload.size() : rng() % 200 + 1));
+                bool fin = pos + part >= payload.size();
+                stream += MakeFrame(first ? 0x1 : 0x0, fin, payload.substr(pos, part), masked, rng());
+                pos += part;
+                first = false;
+
+                if (!fin && rng() % 3 == 0)
+                {
+                    std::string ping = Pattern(rng() % 20, rng());
+                    stream += MakeFrame(0x9, true, ping);
+                    expected.push_back({ FrameDecoder::Event::Ping, ping });
+                }
+            } while (pos < payload.size());
+            expected.push_back({ FrameDecoder::Event::Text, payload });
+        }
+
+        std::vector<size_t> chunks;
+        for (int i = 0; i < 16; ++i)
+            chunks.push_back(1 + rng() % (rng() % 2 ? 16 : 9000));
+
+        FrameDecoder decoder;
+        auto events = Feed(decoder, stream, chunks);
+        CHECK(events == expected);
+        if (events != expected)
+            break;
+    }
+}
+
+int main()
+{
+    RUN_TEST(SingleTextFrame);
+    RUN_TEST(ByteByByteSplits);
+    RUN_TEST(FragmentedWithInterleavedPings);
+    RUN_TEST(LargeFragmentedMessage);
+    RUN_TEST(FragmentedBinaryIsSkipped);
+    RUN_TEST(MaskedFrames);
+    RUN_TEST(ExtendedLengths);
+    RUN_TEST(OversizeRejected);
+    RUN_TEST(ProtocolErrors);
+    RUN_TEST(RandomizedStreams);
+    return TestFailures() == 0 ? 0 : 1;
+}
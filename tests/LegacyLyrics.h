@@ -0,0 +1,134 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Pre-timeline Lyric Structures and DOM Decoder, as References
+ */
+
+#pragma once
+
+#include "TextEncoding.h"
+#include "nlohmann_json.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The lyric structures and the nlohmann DOM walk the client used before
+// LyricTimeline and the SAX decoder, kept as the reference for parity tests
+// and as the baseline for the benchmarks
+namespace LegacyLyrics
+{
+    struct LrcLine
+    {
+        int64_t time = 0;
+        std::wstring text;
+        std::wstring translation;
+    };
+
+    struct YrcWord
+    {
+        int64_t startTime = 0;
+        int64_t duration = 0;
+        std::wstring text;
+    };
+
+    struct YrcLine
+    {
+        int64_t startTime = 0;
+        int64_t endTime = 0;
+        std::vector<YrcWord> words;
+        std::wstring translation;
+    };
+
+    struct LyricData
+    {
+        std::vector<LrcLine> lrcData;
+        std::vector<YrcLine> yrcData;
+        std::vector<LrcLine> transData;
+    };
+
+    // The "data" object of a lyric-change message, walked the old way
+    inline LyricData FromDom(nlohmann::json& data)
+    {
+        LyricData lyricData;
+
+        if (data.contains("lrcData") && data["lrcData"].is_array())
+        {
+            for (auto& item : data["lrcData"])
+            {
+                LrcLine line;
+                line.time = item.value("startTime", (int64_t)0);
+
+                std::string transText = item.value("translatedLyric", "");
+                if (!transText.empty())
+                    line.translation = DecodeUtf8(transText);
+
+                if (item.contains("words") && item["words"].is_array() && !item["words"].empty())
+                {
+                    std::wstring combined;
+                    for (auto& wordItem : item["words"])
+                    {
+                        std::string word = wordItem.value("word", "");
+                        if (!word.empty())
+                            combined += DecodeUtf8(word);
+                    }
+                    line.text = combined;
+                }
+
+                if (!line.text.empty())
+                    lyricData.lrcData.push_back(line);
+            }
+        }
+
+        if (data.contains("yrcData") && data["yrcData"].is_array())
+        {
+            for (auto& item : data["yrcData"])
+            {
+                YrcLine line;
+                line.startTime = item.value("startTime", (int64_t)0);
+                line.endTime = item.value("endTime", (int64_t)0);
+
+                std::string transText = item.value("translatedLyric", "");
+                if (!transText.empty())
+                    line.translation = DecodeUtf8(transText);
+
+                if (item.contains("words") && item["words"].is_array())
+                {
+                    for (auto& wordItem : item["words"])
+                    {
+                        YrcWord word;
+                        word.startTime = wordItem.value("startTime", (int64_t)0);
+                        int64_t endTime = wordItem.value("endTime", (int64_t)0);
+                        word.duration = endTime - word.startTime;
+                        word.text = DecodeUtf8(wordItem.value("word", ""));
+                        if (!word.text.empty())
+                            line.words.push_back(word);
+                    }
+                }
+
+                if (!line.words.empty())
+                    lyricData.yrcData.push_back(line);
+            }
+        }
+
+        if (data.contains("transData") && data["transData"].is_array())
+        {
+            for (auto& item : data["transData"])
+            {
+                LrcLine line;
+                line.time = item.value("startTime", (int64_t)0);
+                line.text = DecodeUtf8(item.value("word", ""));
+                if (!line.text.empty())
+                    lyricData.transData.push_back(line);
+            }
+        }
+
+        return lyricData;
+    }
+
+    // A whole lyric-change message through the DOM
+    inline LyricData Parse(const std::string& message)
+    {
+        nlohmann::json j = nlohmann::json::parse(message);
+        return FromDom(j["data"]);
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * LineLayoutCache Tests
+ */
+
+#include "TestCheck.h"
+#include "FakeTextMeasurer.h"
+#include "LineLayout.h"
+#include <string>
+
+namespace
+{
+    // Three lines, one second apart; words are "aa ", "bbb ", ... so widths differ
+    LyricTimeline MakeTimeline(int lines = 3)
+    {
+        LyricTimeline timeline;
+        for (int line = 0; line < lines; ++line)
+        {
+            timeline.BeginLine();
+            for (int word = 0; word < 3; ++word)
+            {
+                std::string text(2 + word, (char)('a' + word));
+                text += ' ';
+                timeline.BeginWord();
+                timeline.AppendWordText(text);
+                int64_t start = line * 1000 + word * 300;
+                timeline.EndWord(start, start + 300);
+            }
+            timeline.EndLine(line * 1000, line * 1000 + 900);
+        }
+        timeline.Finish();
+        return timeline;
+    }
+}
+
+static void LayoutGeometry()
+{
+    FakeTextMeasurer measurer;
+    LyricTimeline timeline = MakeTimeline();
+    LineLayoutCache cache;
+
+    const LineLayout& layout = cache.Get(timeline, 1, 0, measurer);
+    CHECK_EQ(layout.wordX.size(), 3u);
+    CHECK_EQ(layout.wordWidth.size(), 3u);
+    CHECK_EQ(layout.wordWidth[0], 30);
+    CHECK_EQ(layout.wordWidth[1], 40);
+    CHECK_EQ(layout.wordWidth[2], 50);
+    CHECK_EQ(layout.wordX[0], 0);
+    CHECK_EQ(layout.wordX[1], 30);
+    CHECK_EQ(layout.wordX[2], 70);
+    CHECK_EQ(layout.totalWidth, 120);
+    CHECK_EQ(layout.height, 20);
+}
+
+static void LayoutMeasuredOnce()
+{
+    FakeTextMeasurer measurer;
+    LyricTimeline timeline = MakeTimeline();
+    LineLayoutCache cache;
+
+    cache.Get(timeline, 1, 0, measurer);
+    size_t calls = measurer.calls.size();
+    for (int i = 0; i < 10; ++i)
+        cache.Get(timeline, 1, 0, measurer);
+    CHECK_EQ(measurer.calls.size(), calls);
+    CHECK_EQ(cache.Stats().hits, 10u);
+    CHECK_EQ(cache.Stats().misses, 1u);
+
+    CHECK(cache.Peek(1, 0, measurer.FontId()) != nullptr);
+    CHECK(cache.Peek(1, 1, measurer.FontId()) == nullptr);
+}
+
+// The next line is measured within the lead of its start, and the line
+// change is then a swap
+static void PrefetchThenSwap()
+{
+    FakeTextMeasurer measurer;
+    LyricTimeline timeline = MakeTimeline();
+    LineLayoutCache cache;
+    cache.Get(timeline, 1, 0, measurer);
+
+    CHECK(!cache.Prefetch(timeline, 1, 0, 1000 - LineLayoutCache::PREFETCH_LEAD_MS - 1, measurer));
+    size_t calls = measurer.calls.size();
+    CHECK(cache.Prefetch(timeline, 1, 0, 1000 - LineLayoutCache::PREFETCH_LEAD_MS, measurer));
+    CHECK(measurer.calls.size() > calls);
+    CHECK(!cache.Prefetch(timeline, 1, 0, 900, measurer));
+
+    CHECK(cache.Peek(1, 1, measurer.FontId()) != nullptr);
+    calls = measurer.calls.size();
+    const LineLayout& next = cache.Get(timeline, 1, 1, measurer);
+    CHECK_EQ(measurer.calls.size(), calls);
+    CHECK_EQ(next.lineIndex, 1);
+    CHECK_EQ(cache.Stats().misses, 1u);
+
+    // Nothing after the last line
+    CHECK(!cache.Prefetch(timeline, 1, 2, 2900, measurer));
+}
+
+// New lyrics or a font change miss without any explicit clearing
+static void LyricsOrFontChangeRemeasures()
+{
+    FakeTextMeasurer measurer;
+    LyricTimeline timeline = MakeTimeline();
+    LineLayoutCache cache;
+
+    cache.Get(timeline, 1, 0, measurer);
+    size_t calls = measurer.calls.size();
+
+    // Same line index of a different song
+    CHECK(cache.Peek(2, 0, measurer.FontId()) == nullptr);
+    cache.Get(timeline, 2, 0, measurer);
+    CHECK(measurer.calls.size() > calls);
+    calls = measurer.calls.size();
+
+    measurer.SetFont(14, 28);
+    CHECK(cache.Peek(2, 0, measurer.FontId()) == nullptr);
+    const LineLayout& wide = cache.Get(timeline, 2, 0, measurer);
+    CHECK(measurer.calls.size() > calls);
+    CHECK_EQ(wide.totalWidth, 12 * 14);
+    CHECK_EQ(wide.height, 28);
+
+    // A prefetch made in the old font is not used in the new one
+    measurer.SetFont(10, 20);
+    cache.Get(timeline, 3, 0, measurer);
+    cache.Prefetch(timeline, 3, 0, 900, measurer);
+    measurer.SetFont(14, 28);
+    calls = measurer.calls.size();
+    CHECK_EQ(cache.Get(timeline, 3, 1, measurer).totalWidth, 12 * 14);
+    CHECK(measurer.calls.size() > calls);
+}
+
+int main()
+{
+    RUN_TEST(LayoutGeometry);
+    RUN_TEST(LayoutMeasuredOnce);
+    RUN_TEST(PrefetchThenSwap);
+    RUN_TEST(LyricsOrFontChangeRemeasures);
+    return TestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Loopback Socket Pair for Tests
+ */
+
+#pragma once
+
+#include "SocketIo.h"
+#include <thread>
+
+#ifdef _WIN32
+#include <WS2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace LoopbackSocket
+{
+    inline void CloseSocket(SocketHandle socket)
+    {
+#ifdef _WIN32
+        closesocket(socket);
+#else
+        close(socket);
+#endif
+    }
+
+    inline void SetNonBlocking(SocketHandle socket)
+    {
+#ifdef _WIN32
+        u_long mode = 1;
+        ioctlsocket(socket, FIONBIO, &mode);
+#else
+        fcntl(socket, F_SETFL, fcntl(socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+    }
+
+    // A connected TCP pair over 127.0.0.1, both ends non-blocking with Nagle
+    // off, like the client's connection to SPlayer
+    struct Loopback
+    {
+        SocketHandle client;
+        SocketHandle server;
+
+        Loopback()
+        {
+            SocketHandle listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            sockaddr_in addr = {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = 0;
+            inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+            bind(listener, (sockaddr*)&addr, sizeof(addr));
+            listen(listener, 1);
+            socklen_t addrLen = sizeof(addr);
+            getsockname(listener, (sockaddr*)&addr, &addrLen);
+
+            client = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            connect(client, (sockaddr*)&addr, sizeof(addr));
+            server = accept(listener, nullptr, nullptr);
+            CloseSocket(listener);
+
+            int noDelay = 1;
+            setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+            setsockopt(server, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+            SetNonBlocking(client);
+            SetNonBlocking(server);
+        }
+
+        ~Loopback()
+        {
+            CloseSocket(client);
+            if (server != (SocketHandle)-1)
+                CloseSocket(server);
+        }
+
+        void CloseServer()
+        {
+            CloseSocket(server);
+            server = (SocketHandle)-1;
+        }
+    };
+
+    inline bool SendAllBlocking(SocketHandle socket, const char* data, size_t size)
+    {
+        while (size > 0)
+        {
+            int result = send(socket, data, (int)size, 0);
+            if (result > 0)
+            {
+                data += result;
+                size -= (size_t)result;
+            }
+            else if (result == 0)
+            {
+                return false;
+            }
+            else
+            {
+                // The few bytes sent here never fill a loopback buffer for long
+                std::this_thread::yield();
+            }
+        }
+        return true;
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Render Path Allocation Tests
+ */
+
+#include "CountingAllocator.h"
+#include "TestCheck.h"
+#include "LyricManager.h"
+#include "LyricPayloads.h"
+#include "MessageParser.h"
+
+namespace
+{
+    struct Coverage
+    {
+        int lines = 0;          // Distinct line changes seen
+        int partialWords = 0;   // Frames inside a word
+        size_t characters = 0;  // Keeps the text reads observable
+    };
+
+    // What a render pass reads off a frame
+    void Render(const LyricManager::Frame& frame, Coverage& coverage, int& lastLine)
+    {
+        coverage.characters += frame.CurrentLineText().size() + frame.NextLineText().size() +
+            frame.CurrentTranslation().size() + frame.SongInfoText().size();
+
+        LyricTimeline::LineWords words = frame.CurrentYrcWords();
+        for (size_t i = 0; i < frame.highlight.completedWords && i < words.size(); ++i)
+            coverage.characters += words[i].text.size();
+        if (frame.highlight.activeProgress > 0.0f && frame.highlight.activeProgress < 1.0f)
+            ++coverage.partialWords;
+
+        if (frame.lineIndex != lastLine)
+            ++coverage.lines;
+        lastLine = frame.lineIndex;
+    }
+
+    // Play through a whole song one 60 Hz tick at a time. The lyric offset
+    // moves the clock, so no tick has to wait for real time; a progress
+    // report comes in every 16 ticks as SPlayer's would.
+    Coverage PlayThrough(bool enableYrc, uint64_t& allocations)
+    {
+        LyricManager& manager = LyricManager::Instance();
+        LyricPayloads::Shape shape;
+        MessageParser::Message msg;
+        CHECK(MessageParser::Parse(LyricPayloads::MakeLyricChange(shape), msg));
+
+        SPlayerProtocol::SongInfo song;
+        song.title = L"A song title long enough to live on the heap";
+        manager.SetOptions({ enableYrc, 0 });
+        manager.UpdateSongInfo(song);
+        manager.UpdateLyrics(std::move(msg.lyrics));
+        manager.UpdatePlayStatus(false);
+        manager.UpdateProgress(0);
+
+        Coverage coverage;
+        int lastLine = -1;
+        Render(manager.GetFrame(), coverage, lastLine);
+
+        const int64_t songMs = shape.lines * shape.lineMs;
+        CountingAllocator::Reset();
+        for (int64_t tick = 0; tick * 16 < songMs; ++tick)
+        {
+            if (tick % 16 == 0)
+                manager.UpdateProgress(tick * 16);
+            manager.SetOptions({ enableYrc, (int)(tick % 16) * 16 });
+
+            LyricManager::Frame frame = manager.GetFrame();
+            Render(frame, coverage, lastLine);
+        }
+        allocations = CountingAllocator::Get().allocations;
+        return coverage;
+    }
+}
+
+static void YrcFramesDoNotAllocate()
+{
+    uint64_t allocations = 0;
+    Coverage coverage = PlayThrough(true, allocations);
+    CHECK_EQ(allocations, 0u);
+    CHECK(coverage.lines >= 60);
+    CHECK(coverage.partialWords > 1000);
+}
+
+static void LrcFramesDoNotAllocate()
+{
+    uint64_t allocations = 0;
+    Coverage coverage = PlayThrough(false, allocations);
+    CHECK_EQ(allocations, 0u);
+    CHECK(coverage.lines >= 60);
+    CHECK_EQ(coverage.partialWords, 0);
+}
+
+int main()
+{
+    RUN_TEST(YrcFramesDoNotAllocate);
+    RUN_TEST(LrcFramesDoNotAllocate);
+    return TestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Lyric Handoff Tests: Parse to UpdateLyrics Without Copies
+ */
+
+#include "CountingAllocator.h"
+#include "TestCheck.h"
+#include "MessageParser.h"
+#include "LyricManager.h"
+#include "LyricPayloads.h"
+#include <cstdio>
+#include <functional>
+#include <string>
+
+namespace
+{
+    size_t HeldBytes(const SPlayerProtocol::LyricData& data)
+    {
+        return data.lrcData.MemoryUsage() + data.yrcData.MemoryUsage() + data.transData.MemoryUsage();
+    }
+
+    // Decode a lyric-change message and hand it on the way WebSocketClient
+    // does (through an onLyricChange-style callback into UpdateLyrics), then
+    // check that only the snapshot itself was allocated after parsing
+    void CheckHandoff(const LyricPayloads::Shape& shape)
+    {
+        std::string message = LyricPayloads::MakeLyricChange(shape);
+        LyricManager::Instance();   // Its first call allocates the empty snapshots
+        std::function<void(SPlayerProtocol::LyricData&&)> onLyricChange = [](SPlayerProtocol::LyricData&& data)
+        {
+            LyricManager::Instance().UpdateLyrics(std::move(data));
+        };
+
+        CountingAllocator::Reset();
+        MessageParser::Message msg;
+        CHECK(MessageParser::Parse(message, msg));
+        CountingAllocator::Counters parsed = CountingAllocator::Get();
+
+        const wchar_t* lrcText = msg.lyrics.lrcData.LineText(0).data();
+        const wchar_t* yrcText = msg.lyrics.yrcData.LineText(0).data();
+        size_t held = HeldBytes(msg.lyrics);
+
+        CountingAllocator::Reset();
+        onLyricChange(std::move(msg.lyrics));
+        CountingAllocator::Counters handed = CountingAllocator::Get();
+
+        std::printf("  %zu bytes of JSON, %zu bytes of lyrics: parse %llu allocations / %llu bytes, "
+            "handoff %llu allocations / %llu bytes\n", message.size(), held,
+            (unsigned long long)parsed.allocations, (unsigned long long)parsed.bytes,
+            (unsigned long long)handed.allocations, (unsigned long long)handed.bytes);
+
+        // One make_shared for the snapshot; none of the timelines' storage
+        CHECK(handed.allocations <= 1);
+        CHECK(handed.bytes < sizeof(LyricManager::LyricSnapshot) + 64);
+        CHECK(handed.bytes < held / 4);
+
+        // The published snapshot holds the very arenas the parser filled
+        LyricManager::Frame frame = LyricManager::Instance().GetFrame();
+        CHECK(frame.lyrics->data.lrcData.LineText(0).data() == lrcText);
+        CHECK(frame.lyrics->data.yrcData.LineText(0).data() == yrcText);
+        CHECK_EQ(HeldBytes(frame.lyrics->data), held);
+    }
+}
+
+static void SmallSong()
+{
+    CheckHandoff(LyricPayloads::Shape());
+}
+
+static void LargeSong()
+{
+    LyricPayloads::Shape shape;
+    shape.lines = 1550;
+    CheckHandoff(shape);
+}
+
+// Replacing the lyrics frees the old snapshot instead of keeping a copy
+static void ReplacedSongIsFreed()
+{
+    LyricPayloads::Shape shape;
+    MessageParser::Message first;
+    CHECK(MessageParser::Parse(LyricPayloads::MakeLyricChange(shape, 1), first));
+    LyricManager::Instance().UpdateLyrics(std::move(first.lyrics));
+
+    int64_t before = CountingAllocator::Get().live;
+    MessageParser::Message second;
+    CHECK(MessageParser::Parse(LyricPayloads::MakeLyricChange(shape, 2), second));
+    size_t held = HeldBytes(second.lyrics);
+    LyricManager::Instance().UpdateLyrics(std::move(second.lyrics));
+
+    // About as much is live as before: one song's timelines, not two
+    int64_t grown = CountingAllocator::Get().live - before;
+    CHECK(grown < (int64_t)held / 2);
+}
+
+int main()
+{
+    RUN_TEST(SmallSong);
+    RUN_TEST(LargeSong);
+    RUN_TEST(ReplacedSongIsFreed);
+    return TestFailures() == 0 ? 0 : 1;
+}
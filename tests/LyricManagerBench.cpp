@@ -0,0 +1,161 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * LyricManager Reader Latency Benchmark
+ */
+
+#include "LyricManager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Upper bounds of the histogram buckets in ns; the last one is open
+    const int64_t BUCKETS[] = { 64, 128, 256, 512, 1024, 2048, 4096, 16384, 65536, 262144 };
+    const size_t BUCKET_COUNT = sizeof(BUCKETS) / sizeof(BUCKETS[0]) + 1;
+
+    SPlayerProtocol::LyricData MakeSong(int lines)
+    {
+        SPlayerProtocol::LyricData data;
+        for (int i = 0; i < lines; ++i)
+        {
+            int64_t start = i * 4000;
+            data.lrcData.BeginLine();
+            data.lrcData.AppendLineText("line " + std::to_string(i));
+            data.lrcData.EndLine(start, 0);
+
+            data.yrcData.BeginLine();
+            for (int w = 0; w < 8; ++w)
+            {
+                data.yrcData.BeginWord();
+                data.yrcData.AppendWordText("word ");
+                data.yrcData.EndWord(start + w * 500, start + w * 500 + 500);
+            }
+            data.yrcData.SetLineTranslation("translation");
+            data.yrcData.EndLine(start, start + 4000);
+        }
+        data.lrcData.Finish();
+        data.yrcData.Finish();
+        return data;
+    }
+
+    enum class Writer
+    {
+        Idle,       // Nothing changes while the readers run
+        Playback,   // A progress report every millisecond, a new song every second
+        Hammer,     // Progress reports back to back, a new song every 1000
+    };
+
+    struct Histogram
+    {
+        uint64_t counts[BUCKET_COUNT] = {};
+        std::vector<int64_t> samples;   // Every 16th latency, for percentiles
+    };
+
+    void Run(const char* name, int readerCount, Writer mode)
+    {
+        LyricManager& manager = LyricManager::Instance();
+        manager.Clear();
+        manager.SetOptions({ true, 0 });
+        manager.UpdateLyrics(MakeSong(60));
+        manager.UpdatePlayStatus(true);
+        manager.UpdateProgress(0);
+
+        std::atomic<bool> done{ false };
+        std::vector<Histogram> histograms(readerCount);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < readerCount; ++r)
+        {
+            readers.emplace_back([&, r]
+            {
+                Histogram& histogram = histograms[r];
+                uint64_t n = 0;
+                while (!done.load(std::memory_order_relaxed))
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    LyricManager::Frame frame = manager.GetFrame();
+                    int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+                    size_t bucket = 0;
+                    while (bucket + 1 < BUCKET_COUNT && ns >= BUCKETS[bucket])
+                        ++bucket;
+                    ++histogram.counts[bucket];
+                    if ((n++ & 15) == 0)
+                        histogram.samples.push_back(ns);
+                }
+            });
+        }
+
+        auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        int64_t position = 0;
+        uint64_t updates = 0;
+        while (std::chrono::steady_clock::now() < end)
+        {
+            if (mode == Writer::Idle)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            position = (position + 37) % 240000;
+            manager.UpdateProgress(position);
+            if (++updates % 1000 == 0)
+                manager.UpdateLyrics(MakeSong(60));
+            if (mode == Writer::Playback)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        done.store(true);
+        for (std::thread& reader : readers)
+            reader.join();
+
+        Histogram total;
+        for (const Histogram& histogram : histograms)
+        {
+            for (size_t b = 0; b < BUCKET_COUNT; ++b)
+                total.counts[b] += histogram.counts[b];
+            total.samples.insert(total.samples.end(), histogram.samples.begin(), histogram.samples.end());
+        }
+        std::sort(total.samples.begin(), total.samples.end());
+        uint64_t frames = 0;
+        for (uint64_t count : total.counts)
+            frames += count;
+
+        auto percentile = [&](double p)
+        {
+            return total.samples.empty() ? 0 : total.samples[(size_t)(p * (total.samples.size() - 1))];
+        };
+        std::printf("\n%s: %d reader(s), %llu frames, %llu writer updates\n", name, readerCount,
+            (unsigned long long)frames, (unsigned long long)updates);
+        std::printf("  p50 %lld ns, p99 %lld ns, p99.9 %lld ns, max %lld ns\n", (long long)percentile(0.5),
+            (long long)percentile(0.99), (long long)percentile(0.999), (long long)percentile(1.0));
+        for (size_t b = 0; b < BUCKET_COUNT; ++b)
+        {
+            if (total.counts[b] == 0)
+                continue;
+            double share = 100.0 * total.counts[b] / frames;
+            if (b + 1 < BUCKET_COUNT)
+                std::printf("  < %7lld ns %12llu %6.2f%% ", (long long)BUCKETS[b], (unsigned long long)total.counts[b], share);
+            else
+                std::printf("  >=%7lld ns %12llu %6.2f%% ", (long long)BUCKETS[b - 1], (unsigned long long)total.counts[b], share);
+            std::printf("%.*s\n", (int)(share / 2 + 0.5), "##################################################");
+        }
+    }
+}
+
+int main()
+{
+    int cores = (std::max)(1, (int)std::thread::hardware_concurrency());
+    int readerCounts[] = { 1, (std::max)(2, cores / 2), (std::max)(4, cores) };
+
+    for (int readers : readerCounts)
+    {
+        Run("idle writer", readers, Writer::Idle);
+        Run("playback writer", readers, Writer::Playback);
+        Run("hammering writer", readers, Writer::Hammer);
+    }
+    return 0;
+}
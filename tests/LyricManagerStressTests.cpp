@@ -0,0 +1,225 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * LyricManager Concurrency Tests
+ */
+
+#include "TestCheck.h"
+#include "LyricManager.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const int LYRIC_OFFSET = 250;
+
+    // Song number k: every text of it starts with "k|", so a frame mixing
+    // two songs shows up as differing tags. Even songs also carry YRC.
+    SPlayerProtocol::LyricData MakeSong(int k)
+    {
+        std::string tag = std::to_string(k) + "|";
+        int lines = 3 + k % 20;
+
+        SPlayerProtocol::LyricData data;
+        for (int i = 0; i < lines; ++i)
+        {
+            int64_t start = i * 1000;
+            data.lrcData.BeginLine();
+            data.lrcData.AppendLineText(tag + "line " + std::to_string(i));
+            data.lrcData.SetLineTranslation(tag + "trans");
+            data.lrcData.EndLine(start, 0);
+
+            if (k % 2 == 0)
+            {
+                data.yrcData.BeginLine();
+                for (int w = 0; w < 3; ++w)
+                {
+                    data.yrcData.BeginWord();
+                    data.yrcData.AppendWordText(w == 0 ? tag : "w ");
+                    data.yrcData.EndWord(start + w * 300, start + w * 300 + 300);
+                }
+                data.yrcData.SetLineTranslation(tag + "trans");
+                data.yrcData.EndLine(start, start + 900);
+            }
+        }
+        data.lrcData.Finish();
+        data.yrcData.Finish();
+        return data;
+    }
+
+    std::wstring_view Tag(std::wstring_view text)
+    {
+        size_t bar = text.find(L'|');
+        return bar == std::wstring_view::npos ? std::wstring_view() : text.substr(0, bar + 1);
+    }
+
+    int ReferenceLine(const LyricTimeline& timeline, int64_t time)
+    {
+        int found = -1;
+        for (size_t line = 0; line < timeline.LineCount(); ++line)
+        {
+            if (timeline.LineStart(line) <= time)
+                found = (int)line;
+        }
+        return found;
+    }
+
+    size_t ReferenceCompleted(const LyricTimeline& timeline, size_t line, int64_t time)
+    {
+        size_t count = 0;
+        int64_t settled = INT64_MIN;
+        for (size_t word = timeline.WordBegin(line); word < timeline.WordEnd(line); ++word)
+        {
+            settled = (std::max)(settled, timeline.WordStart(word) + timeline.WordDuration(word));
+            if (settled > time)
+                break;
+            ++count;
+        }
+        return count;
+    }
+
+    // Everything in one frame must come from one lyric snapshot and one
+    // untorn playback state. Returns false on the first inconsistency.
+    bool FrameConsistent(const LyricManager::Frame& frame)
+    {
+        if (!frame.lyrics || !frame.song)
+            return false;
+
+        const SPlayerProtocol::LyricData& data = frame.lyrics->data;
+        if (data.empty())
+            return frame.timeline == nullptr && frame.lineIndex == -1;
+
+        // The timeline belongs to the frame's snapshot and follows the options
+        const LyricTimeline* expected = data.hasYrc() ? &data.yrcData : &data.lrcData;
+        if (frame.timeline != expected)
+            return false;
+
+        // The playback state was written for one snapshot in a single piece:
+        // its line index is the one for its own reported time
+        const LyricManager::PlaybackState& playback = frame.playback;
+        if (playback.lyricsVersion == frame.lyrics->version &&
+            playback.lineIndex != ReferenceLine(*frame.timeline, playback.currentTime + LYRIC_OFFSET))
+            return false;
+
+        // The frame's line is the one playing at the frame's time, or none
+        // while the playback state still refers to another snapshot
+        int line = playback.lyricsVersion == frame.lyrics->version ? ReferenceLine(*frame.timeline, frame.currentTime) : -1;
+        if (frame.lineIndex != line)
+            return false;
+
+        // All texts carry the tag of the snapshot's song
+        std::wstring_view tag = Tag(frame.timeline->LineText(0));
+        if (tag.empty())
+            return false;
+        if (line >= 0 && (Tag(frame.CurrentLineText()) != tag || Tag(frame.CurrentTranslation()) != tag))
+            return false;
+        if (line >= 0 && line + 1 < (int)frame.timeline->LineCount() && Tag(frame.NextLineText()) != tag)
+            return false;
+
+        // The highlight is the word cursor of this line at this time
+        LyricTimeline::LineWords words = frame.CurrentYrcWords();
+        const LyricManager::Highlight& highlight = frame.highlight;
+        if (words.empty())
+            return highlight.completedWords == 0 && highlight.activeWord == -1;
+        if (highlight.completedWords != ReferenceCompleted(*frame.timeline, line, frame.currentTime))
+            return false;
+        if (highlight.completedWords < words.size() ? highlight.activeWord != (int)highlight.completedWords : highlight.activeWord != -1)
+            return false;
+        return highlight.activeProgress >= 0.0f && highlight.activeProgress <= 1.0f;
+    }
+}
+
+// One writer switching songs and reporting progress (with seeks) while
+// readers take frames as fast as they can
+static void ReadersSeeConsistentFrames()
+{
+    LyricManager& manager = LyricManager::Instance();
+    manager.Clear();
+    manager.SetOptions({ true, LYRIC_OFFSET });
+    manager.UpdatePlayStatus(true);
+
+    const int READERS = (std::max)(2, (int)std::thread::hardware_concurrency() - 1);
+    const int SONGS = 500;
+    const int REPORTS_PER_SONG = 40;
+    const long long MIN_FRAMES = 200000;   // Keep writing until the readers got this far too
+
+    std::atomic<bool> done{ false };
+    std::atomic<long long> frames{ 0 };
+    std::atomic<long long> withLine{ 0 };
+    std::atomic<int> failures{ 0 };
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; ++r)
+    {
+        readers.emplace_back([&]
+        {
+            while (!done.load(std::memory_order_acquire))
+            {
+                LyricManager::Frame frame = manager.GetFrame();
+                if (!FrameConsistent(frame))
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                if (frame.lineIndex >= 0)
+                    withLine.fetch_add(1, std::memory_order_relaxed);
+                frames.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    std::mt19937 rng(5);
+    for (int song = 0; song < SONGS || frames.load(std::memory_order_relaxed) < MIN_FRAMES; ++song)
+    {
+        manager.UpdateLyrics(MakeSong(song));
+        int64_t time = rng() % 3000;
+        for (int report = 0; report < REPORTS_PER_SONG; ++report)
+        {
+            time = rng() % 10 == 0 ? (int64_t)(rng() % 25000) - 1000 : time + 37;
+            manager.UpdateProgress(time);
+        }
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& reader : readers)
+        reader.join();
+
+    CHECK_EQ(failures.load(), 0);
+    CHECK(frames.load() > 0);
+    CHECK(withLine.load() > 0);
+}
+
+// The options pick the timeline and shift the lookup time
+static void OptionsApply()
+{
+    LyricManager& manager = LyricManager::Instance();
+    manager.Clear();
+    manager.SetOptions({ false, 0 });
+    manager.UpdateLyrics(MakeSong(0));
+    manager.UpdatePlayStatus(false);
+    manager.UpdateProgress(1500);
+
+    LyricManager::Frame frame = manager.GetFrame();
+    CHECK(frame.timeline == &frame.lyrics->data.lrcData);
+    CHECK_EQ(frame.lineIndex, 1);
+    CHECK(frame.CurrentYrcWords().empty());
+
+    manager.SetOptions({ true, 600 });
+    manager.UpdateProgress(1500);
+    frame = manager.GetFrame();
+    CHECK(frame.timeline == &frame.lyrics->data.yrcData);
+    CHECK_EQ(frame.currentTime, 2100);
+    CHECK_EQ(frame.lineIndex, 2);
+    CHECK_EQ(frame.highlight.completedWords, 0u);
+    CHECK_EQ(frame.highlight.activeWord, 0);
+    CHECK(frame.CurrentLineText() == L"0|w w ");
+}
+
+int main()
+{
+    RUN_TEST(OptionsApply);
+    RUN_TEST(ReadersSeeConsistentFrames);
+    return TestFailures() == 0 ? 0 : 1;
+}
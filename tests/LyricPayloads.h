@@ -0,0 +1,94 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Synthetic lyric-change Messages for Tests and Benchmarks
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+// lyric-change messages shaped like SPlayer's: lrcData and yrcData lines in
+// the AMLL line format (words with timings, romanWord/romanLyric, isBG and
+// isDuet that the plugin skips), plus transData. Deterministic per seed.
+namespace LyricPayloads
+{
+    struct Shape
+    {
+        int lines = 60;             // A 4-minute song
+        int wordsPerLine = 8;
+        bool lrc = true;
+        bool yrc = true;
+        bool translations = true;   // translatedLyric on lrcData/yrcData lines
+        bool transData = true;
+        int64_t lineMs = 4000;
+    };
+
+    inline std::string MakeLyricChange(const Shape& shape, uint32_t seed = 1)
+    {
+        static const char* const WORDS[] = {
+            "\xE4\xBD\xA0", "\xE5\xA5\xBD", "\xE6\x98\x9F", "\xE5\xA4\x9C", "\xE9\x9B\xA8",   // 你 好 星 夜 雨
+            "love ", "night ", "stay ", "light ", "away ",
+            "\xE3\x81\x82", "\xE3\x81\x9F", "\xE3\x81\x97",                                  // あ た し
+            "\\\"quoted\\\" ", "tab\\t ",
+        };
+        const int wordCount = (int)(sizeof(WORDS) / sizeof(WORDS[0]));
+        std::mt19937 rng(seed);
+
+        auto appendLine = [&](std::string& out, int64_t start, bool timedWords)
+        {
+            int64_t wordMs = shape.lineMs / (shape.wordsPerLine > 0 ? shape.wordsPerLine : 1);
+            out += "{\"words\":[";
+            for (int w = 0; w < shape.wordsPerLine; ++w)
+            {
+                int64_t wordStart = timedWords ? start + w * wordMs : 0;
+                int64_t wordEnd = timedWords ? wordStart + wordMs : 0;
+                if (w > 0)
+                    out += ',';
+                out += "{\"word\":\"";
+                out += WORDS[rng() % wordCount];
+                out += "\",\"startTime\":" + std::to_string(wordStart);
+                out += ",\"endTime\":" + std::to_string(wordEnd);
+                out += ",\"romanWord\":\"\"}";
+            }
+            out += "],\"startTime\":" + std::to_string(start);
+            out += ",\"endTime\":" + std::to_string(timedWords ? start + shape.lineMs : 0);
+            out += ",\"translatedLyric\":\"";
+            if (shape.translations)
+            {
+                out += WORDS[rng() % wordCount];
+                out += WORDS[rng() % wordCount];
+            }
+            out += "\",\"romanLyric\":\"\",\"isBG\":false,\"isDuet\":false}";
+        };
+
+        std::string out = "{\"type\":\"lyric-change\",\"data\":{";
+        out += "\"lrcData\":[";
+        for (int i = 0; shape.lrc && i < shape.lines; ++i)
+        {
+            if (i > 0)
+                out += ',';
+            appendLine(out, i * shape.lineMs, false);
+        }
+        out += "],\"yrcData\":[";
+        for (int i = 0; shape.yrc && i < shape.lines; ++i)
+        {
+            if (i > 0)
+                out += ',';
+            appendLine(out, i * shape.lineMs, true);
+        }
+        out += "],\"transData\":[";
+        for (int i = 0; shape.transData && i < shape.lines; ++i)
+        {
+            if (i > 0)
+                out += ',';
+            out += "{\"startTime\":" + std::to_string(i * shape.lineMs) + ",\"word\":\"";
+            out += WORDS[rng() % wordCount];
+            out += "\"}";
+        }
+        out += "]}}";
+        return out;
+    }
+}
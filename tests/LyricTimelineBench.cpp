@@ -0,0 +1,105 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * LyricTimeline Line Lookup Benchmark
+ */
+
+#include "LyricTimeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const int64_t LINE_MS = 3000;
+    const int64_t FRAME_MS = 16;    // One lookup per 60 Hz frame
+
+    LyricTimeline MakeTimeline(int lines)
+    {
+        LyricTimeline timeline;
+        for (int i = 0; i < lines; ++i)
+        {
+            timeline.BeginLine();
+            timeline.AppendLineText("line");
+            timeline.EndLine(i * LINE_MS, 0);
+        }
+        timeline.Finish();
+        return timeline;
+    }
+
+    // Times of a playback path: frame steps through the whole song
+    std::vector<int64_t> Playback(int lines)
+    {
+        std::vector<int64_t> times;
+        for (int64_t time = -1000; time < lines * LINE_MS; time += FRAME_MS)
+            times.push_back(time);
+        return times;
+    }
+
+    // Times of a user dragging the seek bar around
+    std::vector<int64_t> RandomSeeks(int lines, size_t count)
+    {
+        std::mt19937 rng(3);
+        std::vector<int64_t> times(count);
+        for (int64_t& time : times)
+            time = (int64_t)(rng() % (uint32_t)(lines * LINE_MS));
+        return times;
+    }
+
+    // ns per lookup, the previous result fed back as the hint (as the
+    // manager does) or a plain binary search over the start times
+    double Measure(const LyricTimeline& timeline, const std::vector<int64_t>& times, bool hinted)
+    {
+        std::vector<int64_t> starts;
+        for (size_t i = 0; i < timeline.LineCount(); ++i)
+            starts.push_back(timeline.LineStart(i));
+
+        size_t rounds = 20000000 / times.size() + 1;
+        long long sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            int line = -1;
+            for (int64_t time : times)
+            {
+                if (hinted)
+                    line = timeline.FindLine(time, line);
+                else
+                    line = (int)(std::upper_bound(starts.begin(), starts.end(), time) - starts.begin()) - 1;
+                sink += line;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Keep the result observable so the loop is not dropped
+        volatile long long observed = sink;
+        (void)observed;
+        return seconds * 1e9 / ((double)rounds * times.size());
+    }
+}
+
+int main()
+{
+    struct
+    {
+        const char* name;
+        int lines;
+        bool seek;
+    } workloads[] = {
+        { "10 lines, playback", 10, false },
+        { "5000 lines, playback", 5000, false },
+        { "10 lines, random seek", 10, true },
+        { "5000 lines, random seek", 5000, true },
+    };
+
+    std::printf("%-26s %14s %14s\n", "ns/lookup", "FindLine+hint", "upper_bound");
+    for (const auto& w : workloads)
+    {
+        LyricTimeline timeline = MakeTimeline(w.lines);
+        std::vector<int64_t> times = w.seek ? RandomSeeks(w.lines, 100000) : Playback(w.lines);
+        std::printf("%-26s %14.2f %14.2f\n", w.name, Measure(timeline, times, true), Measure(timeline, times, false));
+    }
+    return 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Lyric Storage Memory Benchmark: LyricTimeline vs Per-line Vectors
+ */
+
+#include "CountingAllocator.h"
+#include "LyricTimeline.h"
+#include "LegacyLyrics.h"
+#include "TextEncoding.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // A synthetic 4-minute song: 60 lines of 8 timed words, each line with
+    // a translation, the way SPlayer sends yrcData (and lrcData untimed)
+    struct Song
+    {
+        struct Line
+        {
+            int64_t start = 0;
+            int64_t end = 0;
+            std::vector<std::string> words;     // UTF-8
+            std::string translation;
+        };
+        std::vector<Line> lines;
+
+        static const int64_t LINE_MS = 4000;
+        static const int64_t WORD_MS = LINE_MS / 8;
+    };
+
+    Song MakeSong()
+    {
+        static const char* const WORDS[] = {
+            "\xE4\xBD\xA0", "\xE5\xA5\xBD", "\xE6\x98\x9F", "\xE5\xA4\x9C", "\xE9\x9B\xA8",   // 你 好 星 夜 雨
+            "love ", "night ", "stay ", "light ", "away ",
+            "\xE3\x81\x82", "\xE3\x81\x9F", "\xE3\x81\x97",                                  // あ た し
+        };
+        const size_t wordCount = sizeof(WORDS) / sizeof(WORDS[0]);
+
+        Song song;
+        for (int i = 0; i < 60; ++i)
+        {
+            Song::Line line;
+            line.start = i * Song::LINE_MS;
+            line.end = line.start + Song::LINE_MS;
+            for (int w = 0; w < 8; ++w)
+                line.words.push_back(WORDS[(i * 7 + w * 3) % wordCount]);
+            line.translation = std::string(WORDS[i % wordCount]) + WORDS[(i + 5) % wordCount] + WORDS[(i + 9) % wordCount];
+            song.lines.push_back(std::move(line));
+        }
+        return song;
+    }
+
+    // The old representation, filled the way the DOM walk filled it
+    void BuildLegacy(const Song& song, bool timed, LegacyLyrics::LyricData& out)
+    {
+        for (const Song::Line& source : song.lines)
+        {
+            if (timed)
+            {
+                LegacyLyrics::YrcLine line;
+                line.startTime = source.start;
+                line.endTime = source.end;
+                line.translation = DecodeUtf8(source.translation);
+                for (size_t w = 0; w < source.words.size(); ++w)
+                {
+                    LegacyLyrics::YrcWord word;
+                    word.startTime = source.start + (int64_t)w * Song::WORD_MS;
+                    word.duration = Song::WORD_MS;
+                    word.text = DecodeUtf8(source.words[w]);
+                    line.words.push_back(word);
+                }
+                out.yrcData.push_back(line);
+            }
+            else
+            {
+                LegacyLyrics::LrcLine line;
+                line.time = source.start;
+                line.translation = DecodeUtf8(source.translation);
+                std::wstring combined;
+                for (const std::string& word : source.words)
+                    combined += DecodeUtf8(word);
+                line.text = combined;
+                out.lrcData.push_back(line);
+            }
+        }
+    }
+
+    // The same lines through the builder the SAX decoder drives
+    void BuildTimeline(const Song& song, bool timed, LyricTimeline& out)
+    {
+        for (const Song::Line& source : song.lines)
+        {
+            out.BeginLine();
+            for (size_t w = 0; w < source.words.size(); ++w)
+            {
+                if (timed)
+                {
+                    int64_t start = source.start + (int64_t)w * Song::WORD_MS;
+                    out.BeginWord();
+                    out.AppendWordText(source.words[w]);
+                    out.EndWord(start, start + Song::WORD_MS);
+                }
+                else
+                {
+                    out.AppendLineText(source.words[w]);
+                }
+            }
+            out.SetLineTranslation(source.translation);
+            out.EndLine(source.start, timed ? source.end : 0);
+        }
+        out.Finish();
+    }
+
+    struct Usage
+    {
+        int64_t held = 0;           // Heap bytes still live once built
+        int64_t peak = 0;           // Highest heap bytes while building
+        uint64_t allocations = 0;   // operator new calls while building
+    };
+
+    template <typename Build>
+    Usage Measure(Build build)
+    {
+        int64_t before = CountingAllocator::Get().live;
+        CountingAllocator::Reset();
+        build();
+        CountingAllocator::Counters counters = CountingAllocator::Get();
+
+        Usage usage;
+        usage.held = counters.live - before;
+        usage.peak = counters.peak - before;
+        usage.allocations = counters.allocations;
+        return usage;
+    }
+
+    void Print(const char* name, const Usage& usage)
+    {
+        std::printf("%-28s %10lld %10lld %12llu\n", name, (long long)usage.held, (long long)usage.peak,
+            (unsigned long long)usage.allocations);
+    }
+}
+
+int main()
+{
+    Song song = MakeSong();
+    std::printf("Synthetic song: %zu lines, %zu words per line, with translations (wchar_t is %zu bytes)\n\n",
+        song.lines.size(), song.lines[0].words.size(), sizeof(wchar_t));
+    std::printf("%-28s %10s %10s %12s\n", "representation", "held", "peak", "allocations");
+
+    // Each result is kept alive until its numbers are taken
+    {
+        LegacyLyrics::LyricData legacy;
+        Print("yrc  vector<YrcLine>", Measure([&] { BuildLegacy(song, true, legacy); }));
+    }
+    {
+        LyricTimeline timeline;
+        Usage usage = Measure([&] { BuildTimeline(song, true, timeline); });
+        Print("yrc  LyricTimeline", usage);
+        std::printf("%-28s %10zu\n", "     (MemoryUsage)", timeline.MemoryUsage());
+    }
+    {
+        LegacyLyrics::LyricData legacy;
+        Print("lrc  vector<LrcLine>", Measure([&] { BuildLegacy(song, false, legacy); }));
+    }
+    {
+        LyricTimeline timeline;
+        Usage usage = Measure([&] { BuildTimeline(song, false, timeline); });
+        Print("lrc  LyricTimeline", usage);
+        std::printf("%-28s %10zu\n", "     (MemoryUsage)", timeline.MemoryUsage());
+    }
+    return 0;
+}
@@ -0,0 +1,346 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * LyricTimeline Line Lookup and Word Cursor Tests
+ */
+
+#include "TestCheck.h"
+#include "LyricTimeline.h"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct TimedWord
+    {
+        int64_t start;
+        int64_t end;
+    };
+
+    LyricTimeline MakeLine(int64_t lineStart, int64_t lineEnd, const std::vector<TimedWord>& words)
+    {
+        LyricTimeline timeline;
+        timeline.BeginLine();
+        for (const TimedWord& word : words)
+        {
+            timeline.BeginWord();
+            timeline.AppendWordText("w ");
+            timeline.EndWord(word.start, word.end);
+        }
+        timeline.EndLine(lineStart, lineEnd);
+        timeline.Finish();
+        return timeline;
+    }
+
+    // Untimed lines in the given order; each line's text is its position in
+    // starts, so the order after Finish can be checked
+    LyricTimeline MakeLines(const std::vector<int64_t>& starts, const std::vector<int64_t>& ends = {})
+    {
+        LyricTimeline timeline;
+        for (size_t i = 0; i < starts.size(); ++i)
+        {
+            timeline.BeginLine();
+            timeline.AppendLineText(std::to_string(i));
+            timeline.EndLine(starts[i], i < ends.size() ? ends[i] : 0);
+        }
+        timeline.Finish();
+        return timeline;
+    }
+
+    // Straightforward definition: the last line starting at or before time
+    int ReferenceLine(const LyricTimeline& timeline, int64_t time)
+    {
+        int found = -1;
+        for (size_t line = 0; line < timeline.LineCount(); ++line)
+        {
+            if (timeline.LineStart(line) <= time)
+                found = (int)line;
+        }
+        return found;
+    }
+
+    // Straightforward definition: leading words whose own end and every
+    // earlier word's end have passed
+    size_t Reference(const LyricTimeline& timeline, size_t line, int64_t time)
+    {
+        size_t count = 0;
+        for (size_t word = timeline.WordBegin(line); word < timeline.WordEnd(line); ++word)
+        {
+            if (timeline.WordStart(word) + timeline.WordDuration(word) > time)
+                break;
+            ++count;
+        }
+        return count;
+    }
+}
+
+// Nothing is playing before the first line or without lines, whatever the hint
+static void FindLineBeforeFirst()
+{
+    LyricTimeline empty;
+    CHECK_EQ(empty.FindLine(0), -1);
+    CHECK_EQ(empty.FindLine(1000, 0), -1);
+
+    LyricTimeline timeline = MakeLines({ 1000, 2000, 3000 });
+    CHECK_EQ(timeline.FindLine(-5), -1);
+    CHECK_EQ(timeline.FindLine(999), -1);
+    CHECK_EQ(timeline.FindLine(999, 0), -1);
+    CHECK_EQ(timeline.FindLine(999, 2), -1);
+    CHECK_EQ(timeline.FindLine(1000), 0);
+    CHECK_EQ(timeline.FindLine(1000, -1), 0);
+}
+
+// Between a line's end and the next start the earlier line stays current
+static void FindLineGaps()
+{
+    LyricTimeline timeline = MakeLines({ 0, 5000, 20000 }, { 1000, 6000, 21000 });
+    CHECK_EQ(timeline.LineEnd(0), 1000);
+    CHECK_EQ(timeline.FindLine(1500), 0);
+    CHECK_EQ(timeline.FindLine(4999, 0), 0);
+    CHECK_EQ(timeline.FindLine(5000, 0), 1);
+    CHECK_EQ(timeline.FindLine(19999, 1), 1);
+    CHECK_EQ(timeline.FindLine(19999, 0), 1);
+    CHECK_EQ(timeline.FindLine(20000, 1), 2);
+    CHECK_EQ(timeline.FindLine(999999, 1), 2);
+}
+
+// Lines starting together: the last of them wins, with or without a hint,
+// and the earlier ones keep their arrival order
+static void FindLineEqualStarts()
+{
+    LyricTimeline timeline = MakeLines({ 0, 1000, 1000, 1000, 2000 });
+    CHECK(timeline.LineText(1) == L"1" && timeline.LineText(2) == L"2" && timeline.LineText(3) == L"3");
+    for (int hint = -1; hint <= 5; ++hint)
+    {
+        CHECK_EQ(timeline.FindLine(999, hint), 0);
+        CHECK_EQ(timeline.FindLine(1000, hint), 3);
+        CHECK_EQ(timeline.FindLine(1999, hint), 3);
+        CHECK_EQ(timeline.FindLine(2000, hint), 4);
+    }
+    // Lines without an end time run until the next different start
+    CHECK_EQ(timeline.LineEnd(0), 1000);
+    CHECK_EQ(timeline.LineEnd(3), 2000);
+}
+
+// Any hint, however stale or out of range, gives the same answer as none
+static void FindLineHints()
+{
+    std::mt19937 rng(11);
+    std::vector<int64_t> starts;
+    int64_t start = 0;
+    for (int i = 0; i < 200; ++i)
+    {
+        start += rng() % 4 == 0 ? 0 : 1 + rng() % 6000;
+        starts.push_back(start);
+    }
+    LyricTimeline timeline = MakeLines(starts);
+
+    const int count = (int)timeline.LineCount();
+    const int hints[] = { -100, -2, -1, 0, 1, count / 2, count - 2, count - 1, count, count + 1, 1 << 30 };
+    for (int round = 0; round < 2000; ++round)
+    {
+        int64_t time = (int64_t)(rng() % (uint32_t)(start + 10000)) - 5000;
+        int expected = ReferenceLine(timeline, time);
+        CHECK_EQ(timeline.FindLine(time), expected);
+        for (int hint : hints)
+            CHECK_EQ(timeline.FindLine(time, hint), expected);
+        CHECK_EQ(timeline.FindLine(time, (int)(rng() % count)), expected);
+    }
+
+    // Playback: each result is the next hint, with an occasional seek
+    int hint = -1;
+    int64_t time = -1000;
+    for (int step = 0; step < 20000; ++step)
+    {
+        time = rng() % 500 == 0 ? (int64_t)(rng() % (uint32_t)start) : time + 16;
+        hint = timeline.FindLine(time, hint);
+        CHECK_EQ(hint, ReferenceLine(timeline, time));
+    }
+}
+
+// Lines arriving out of order are sorted once by Finish, words and
+// translations moving with their line
+static void FindLineUnsortedInput()
+{
+    LyricTimeline timeline;
+    const int64_t starts[] = { 3000, 1000, 4000, 0, 2000 };
+    for (int64_t lineStart : starts)
+    {
+        std::string name = std::to_string(lineStart / 1000);
+        timeline.BeginLine();
+        timeline.BeginWord();
+        timeline.AppendWordText(name);
+        timeline.EndWord(lineStart, lineStart + 500);
+        timeline.BeginWord();
+        timeline.AppendWordText("!");
+        timeline.EndWord(lineStart + 500, lineStart + 900);
+        timeline.SetLineTranslation("t" + name);
+        timeline.EndLine(lineStart, lineStart + 900);
+    }
+    timeline.Finish();
+
+    CHECK_EQ(timeline.LineCount(), 5u);
+    for (size_t line = 0; line < timeline.LineCount(); ++line)
+    {
+        std::wstring name = std::to_wstring(line);
+        CHECK_EQ(timeline.LineStart(line), (int64_t)line * 1000);
+        CHECK(timeline.LineText(line) == name + L"!");
+        CHECK(timeline.LineTranslation(line) == L"t" + name);
+        CHECK_EQ(timeline.Words(line).size(), 2u);
+        CHECK(timeline.Words(line)[0].text == name);
+        CHECK_EQ(timeline.Words(line)[1].startTime, (int64_t)line * 1000 + 500);
+        CHECK_EQ(timeline.CompletedWords(line, (int64_t)line * 1000 + 500), 1u);
+    }
+    CHECK_EQ(timeline.FindLine(2500), 2);
+    CHECK_EQ(timeline.FindLine(2500, 4), 2);
+    CHECK_EQ(timeline.FindLine(-1, 3), -1);
+}
+
+static void SequentialWords()
+{
+    LyricTimeline timeline = MakeLine(1000, 2000, { { 1000, 1200 }, { 1200, 1500 }, { 1500, 2000 } });
+    CHECK_EQ(timeline.CompletedWords(0, 999), 0u);
+    CHECK_EQ(timeline.CompletedWords(0, 1199), 0u);
+    CHECK_EQ(timeline.CompletedWords(0, 1200), 1u);
+    CHECK_EQ(timeline.CompletedWords(0, 1500), 2u);
+    CHECK_EQ(timeline.CompletedWords(0, 5000), 3u);
+}
+
+// A word that ends before an earlier, longer one does not count until that one has ended
+static void OverlappingWords()
+{
+    LyricTimeline timeline = MakeLine(0, 2000, { { 0, 800 }, { 300, 500 }, { 800, 1000 } });
+    CHECK_EQ(timeline.CompletedWords(0, 500), 0u);
+    CHECK_EQ(timeline.CompletedWords(0, 799), 0u);
+    CHECK_EQ(timeline.CompletedWords(0, 800), 2u);
+    CHECK_EQ(timeline.CompletedWords(0, 1000), 3u);
+
+    // Same answers when walking the cursor with hints, both ways
+    size_t hint = 0;
+    for (int64_t time = 0; time <= 1100; time += 10)
+    {
+        hint = timeline.CompletedWords(0, time, hint);
+        CHECK_EQ(hint, Reference(timeline, 0, time));
+    }
+    for (int64_t time = 1100; time >= 0; time -= 10)
+    {
+        hint = timeline.CompletedWords(0, time, hint);
+        CHECK_EQ(hint, Reference(timeline, 0, time));
+    }
+}
+
+// Zero-length words complete the moment they start
+static void ZeroDurationWords()
+{
+    LyricTimeline timeline = MakeLine(0, 2000, { { 0, 400 }, { 400, 400 }, { 400, 400 }, { 400, 900 } });
+    CHECK_EQ(timeline.CompletedWords(0, 399), 0u);
+    CHECK_EQ(timeline.CompletedWords(0, 400), 3u);
+    CHECK_EQ(timeline.CompletedWords(0, 899), 3u);
+    CHECK_EQ(timeline.CompletedWords(0, 900), 4u);
+
+    LyricTimeline leading = MakeLine(100, 2000, { { 100, 100 }, { 100, 300 } });
+    CHECK_EQ(leading.CompletedWords(0, 99), 0u);
+    CHECK_EQ(leading.CompletedWords(0, 100), 1u);
+}
+
+// In a gap between words the cursor stays after the last finished word
+static void GappedWords()
+{
+    LyricTimeline timeline = MakeLine(0, 5000, { { 0, 300 }, { 1000, 1300 }, { 3000, 3500 } });
+    CHECK_EQ(timeline.CompletedWords(0, 300), 1u);
+    CHECK_EQ(timeline.CompletedWords(0, 999), 1u);
+    CHECK_EQ(timeline.CompletedWords(0, 2000), 2u);
+    CHECK_EQ(timeline.CompletedWords(0, 2999), 2u);
+    CHECK_EQ(timeline.CompletedWords(0, 3500), 3u);
+
+    // A stale hint past the answer is corrected, as after a seek back
+    CHECK_EQ(timeline.CompletedWords(0, 500, 3), 1u);
+    CHECK_EQ(timeline.CompletedWords(0, 2000, 0), 2u);
+    CHECK_EQ(timeline.CompletedWords(0, 2000, 99), 2u);
+}
+
+// Words only count within their own line
+static void MultipleLines()
+{
+    LyricTimeline timeline;
+    for (int line = 0; line < 3; ++line)
+    {
+        timeline.BeginLine();
+        for (int word = 0; word < 4; ++word)
+        {
+            timeline.BeginWord();
+            timeline.AppendWordText("ab");
+            int64_t start = line * 1000 + word * 200;
+            timeline.EndWord(start, start + 200);
+        }
+        timeline.EndLine(line * 1000, line * 1000 + 800);
+    }
+    timeline.Finish();
+
+    CHECK_EQ(timeline.CompletedWords(1, 900), 0u);
+    CHECK_EQ(timeline.CompletedWords(1, 1400), 2u);
+    CHECK_EQ(timeline.CompletedWords(1, 9000), 4u);
+    CHECK_EQ(timeline.CompletedWords(2, 1400), 0u);
+}
+
+// Random mixes of overlaps, zero-length words and gaps, queried along a
+// playback path with seeks, against the reference
+static void RandomizedLines()
+{
+    std::mt19937 rng(7);
+    for (int round = 0; round < 300; ++round)
+    {
+        LyricTimeline timeline;
+        int lines = 1 + rng() % 4;
+        for (int line = 0; line < lines; ++line)
+        {
+            timeline.BeginLine();
+            int64_t cursor = line * 10000;
+            int words = rng() % 10;
+            for (int word = 0; word < words; ++word)
+            {
+                int64_t start = cursor + (rng() % 3 == 0 ? rng() % 500 : 0);
+                int64_t duration = rng() % 4 == 0 ? 0 : rng() % 600;
+                timeline.BeginWord();
+                timeline.AppendWordText("x");
+                timeline.EndWord(start, start + duration);
+                cursor = (std::max)(start, start + duration - (rng() % 3 == 0 ? (int64_t)(rng() % 200) : 0));
+            }
+            timeline.AppendLineText(words == 0 ? "untimed" : "");
+            timeline.EndLine(line * 10000, line * 10000 + 9000);
+        }
+        timeline.Finish();
+
+        for (size_t line = 0; line < timeline.LineCount(); ++line)
+        {
+            size_t hint = 0;
+            int64_t time = timeline.LineStart(line) - 100;
+            for (int step = 0; step < 300; ++step)
+            {
+                time = rng() % 20 == 0 ? timeline.LineStart(line) + rng() % 6000 : time + 17;
+                size_t result = timeline.CompletedWords(line, time, hint);
+                CHECK_EQ(result, Reference(timeline, line, time));
+                hint = result;
+            }
+        }
+    }
+}
+
+int main()
+{
+    RUN_TEST(FindLineBeforeFirst);
+    RUN_TEST(FindLineGaps);
+    RUN_TEST(FindLineEqualStarts);
+    RUN_TEST(FindLineHints);
+    RUN_TEST(FindLineUnsortedInput);
+    RUN_TEST(SequentialWords);
+    RUN_TEST(OverlappingWords);
+    RUN_TEST(ZeroDurationWords);
+    RUN_TEST(GappedWords);
+    RUN_TEST(MultipleLines);
+    RUN_TEST(RandomizedLines);
+    return TestFailures() == 0 ? 0 : 1;
+}
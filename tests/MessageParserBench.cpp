@@ -0,0 +1,111 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * MessageParser Benchmark: SAX Decoder vs the Old DOM Walk
+ */
+
+#include "CountingAllocator.h"
+#include "MessageParser.h"
+#include "LegacyLyrics.h"
+#include "LyricPayloads.h"
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+    struct Result
+    {
+        double microseconds = 0;    // Per message
+        int64_t peak = 0;           // Heap bytes above the baseline while decoding one
+        uint64_t allocations = 0;   // Per message
+    };
+
+    // The whole of one message the old way: DOM, type lookup, lyric walk
+    size_t ParseDom(const std::string& message)
+    {
+        nlohmann::json j = nlohmann::json::parse(message);
+        std::string type = j.value("type", "");
+        LegacyLyrics::LyricData data = LegacyLyrics::FromDom(j["data"]);
+        return type.size() + data.lrcData.size() + data.yrcData.size() + data.transData.size();
+    }
+
+    size_t ParseSax(const std::string& message)
+    {
+        MessageParser::Message msg;
+        MessageParser::Parse(message, msg);
+        return (size_t)msg.type + msg.lyrics.lrcData.LineCount() + msg.lyrics.yrcData.LineCount() +
+            msg.lyrics.transData.LineCount();
+    }
+
+    template <typename Parse>
+    Result Measure(Parse parse, const std::string& message)
+    {
+        Result result;
+        int64_t before = CountingAllocator::Get().live;
+        CountingAllocator::Reset();
+        volatile size_t sink = parse(message);
+        CountingAllocator::Counters counters = CountingAllocator::Get();
+        result.peak = counters.peak - before;
+        result.allocations = counters.allocations;
+
+        int rounds = (int)(64 * 1024 * 1024 / (message.size() + 1)) + 1;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i)
+            sink = sink + parse(message);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.microseconds = seconds * 1e6 / rounds;
+        return result;
+    }
+}
+
+int main()
+{
+    struct
+    {
+        const char* name;
+        int lines;
+        bool yrc;
+        bool translations;
+    } cases[] = {
+        { "lrc 60 lines", 60, false, false },
+        { "yrc 60 lines", 60, true, false },
+        { "yrc+trans 60", 60, true, true },
+        { "yrc+trans 1550", 1550, true, true },
+    };
+
+    std::printf("%-16s %9s %10s %10s %10s %10s %10s %10s\n", "message", "bytes",
+        "dom us", "sax us", "dom peak", "sax peak", "dom allocs", "sax allocs");
+    for (const auto& c : cases)
+    {
+        LyricPayloads::Shape shape;
+        shape.lines = c.lines;
+        shape.yrc = c.yrc;
+        shape.translations = c.translations;
+        shape.transData = c.translations;
+        std::string message = LyricPayloads::MakeLyricChange(shape);
+
+        Result dom = Measure(ParseDom, message);
+        Result sax = Measure(ParseSax, message);
+        std::printf("%-16s %9zu %10.1f %10.1f %10lld %10lld %10llu %10llu\n", c.name, message.size(),
+            dom.microseconds, sax.microseconds, (long long)dom.peak, (long long)sax.peak,
+            (unsigned long long)dom.allocations, (unsigned long long)sax.allocations);
+    }
+
+    std::string progress = R"({"type":"progress-change","data":{"currentTime":61234,"duration":215000}})";
+    Result dom = Measure([](const std::string& message)
+    {
+        nlohmann::json j = nlohmann::json::parse(message);
+        return (size_t)j["data"].value("currentTime", (int64_t)0);
+    }, progress);
+    Result sax = Measure([](const std::string& message)
+    {
+        MessageParser::Message msg;
+        MessageParser::Parse(message, msg);
+        return (size_t)msg.progress.currentTime;
+    }, progress);
+    std::printf("%-16s %9zu %10.2f %10.2f %10lld %10lld %10llu %10llu\n", "progress-change", progress.size(),
+        dom.microseconds, sax.microseconds, (long long)dom.peak, (long long)sax.peak,
+        (unsigned long long)dom.allocations, (unsigned long long)sax.allocations);
+    return 0;
+}
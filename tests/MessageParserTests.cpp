@@ -0,0 +1,214 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * MessageParser Tests: SAX Decoder Against the Old DOM Walk
+ */
+
+#include "TestCheck.h"
+#include "MessageParser.h"
+#include "LegacyLyrics.h"
+#include "LyricPayloads.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using SPlayerProtocol::MessageType;
+
+namespace
+{
+    bool SameLrc(const LyricTimeline& timeline, const std::vector<LegacyLyrics::LrcLine>& lines)
+    {
+        if (timeline.LineCount() != lines.size())
+            return false;
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            if (timeline.LineStart(i) != lines[i].time || timeline.LineText(i) != lines[i].text ||
+                timeline.LineTranslation(i) != lines[i].translation || !timeline.Words(i).empty())
+                return false;
+        }
+        return true;
+    }
+
+    bool SameYrc(const LyricTimeline& timeline, const std::vector<LegacyLyrics::YrcLine>& lines)
+    {
+        if (timeline.LineCount() != lines.size())
+            return false;
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            const LegacyLyrics::YrcLine& line = lines[i];
+            LyricTimeline::LineWords words = timeline.Words(i);
+            std::wstring text;
+            for (const LegacyLyrics::YrcWord& word : line.words)
+                text += word.text;
+
+            // Lines without an end time get one when the timeline is finished
+            bool endMatches = line.endTime > line.startTime ? timeline.LineEnd(i) == line.endTime : true;
+            if (timeline.LineStart(i) != line.startTime || !endMatches || timeline.LineText(i) != text ||
+                timeline.LineTranslation(i) != line.translation || words.size() != line.words.size())
+                return false;
+
+            for (size_t w = 0; w < words.size(); ++w)
+            {
+                LyricTimeline::Word word = words[w];
+                if (word.startTime != line.words[w].startTime || word.duration != line.words[w].duration ||
+                    word.text != line.words[w].text)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // Decode with both paths and compare everything the old one produced
+    bool MatchesDom(const std::string& message)
+    {
+        MessageParser::Message msg;
+        if (!MessageParser::Parse(message, msg) || msg.type != MessageType::LyricChange)
+            return false;
+
+        // The timeline orders lines by start time once, keeping ties in
+        // arrival order; the DOM walk kept them as sent
+        LegacyLyrics::LyricData legacy = LegacyLyrics::Parse(message);
+        auto byTime = [](const LegacyLyrics::LrcLine& a, const LegacyLyrics::LrcLine& b) { return a.time < b.time; };
+        std::stable_sort(legacy.lrcData.begin(), legacy.lrcData.end(), byTime);
+        std::stable_sort(legacy.transData.begin(), legacy.transData.end(), byTime);
+        std::stable_sort(legacy.yrcData.begin(), legacy.yrcData.end(),
+            [](const LegacyLyrics::YrcLine& a, const LegacyLyrics::YrcLine& b) { return a.startTime < b.startTime; });
+        return SameLrc(msg.lyrics.lrcData, legacy.lrcData) &&
+            SameYrc(msg.lyrics.yrcData, legacy.yrcData) &&
+            SameLrc(msg.lyrics.transData, legacy.transData);
+    }
+}
+
+static void LrcOnly()
+{
+    LyricPayloads::Shape shape;
+    shape.yrc = false;
+    shape.translations = false;
+    shape.transData = false;
+    CHECK(MatchesDom(LyricPayloads::MakeLyricChange(shape)));
+
+    MessageParser::Message msg;
+    CHECK(MessageParser::Parse(LyricPayloads::MakeLyricChange(shape), msg));
+    CHECK_EQ(msg.lyrics.lrcData.LineCount(), 60u);
+    CHECK(!msg.lyrics.hasYrc());
+}
+
+static void Yrc()
+{
+    LyricPayloads::Shape shape;
+    shape.lrc = false;
+    shape.translations = false;
+    shape.transData = false;
+    CHECK(MatchesDom(LyricPayloads::MakeLyricChange(shape)));
+
+    MessageParser::Message msg;
+    CHECK(MessageParser::Parse(LyricPayloads::MakeLyricChange(shape), msg));
+    CHECK_EQ(msg.lyrics.yrcData.LineCount(), 60u);
+    CHECK_EQ(msg.lyrics.yrcData.WordCount(), 480u);
+}
+
+static void YrcWithTranslations()
+{
+    for (uint32_t seed = 1; seed <= 20; ++seed)
+    {
+        LyricPayloads::Shape shape;
+        shape.lines = 10 + (int)seed * 7;
+        shape.wordsPerLine = 1 + (int)seed % 12;
+        CHECK(MatchesDom(LyricPayloads::MakeLyricChange(shape, seed)));
+    }
+}
+
+// Fields left out, empty texts and stray values: whatever the DOM walk kept
+// or dropped, the SAX decoder must keep or drop too
+static void MissingFields()
+{
+    const char* messages[] = {
+        // No data at all, and data without any lyric arrays
+        R"({"type":"lyric-change"})",
+        R"({"type":"lyric-change","data":{}})",
+        // Lines without startTime or words, words without a text or times
+        R"({"type":"lyric-change","data":{"lrcData":[{"words":[{"word":"a"}]},{"startTime":5},{"startTime":9,"words":[]},)"
+            R"({"startTime":12,"words":[{"startTime":1},{"word":"b"},{"word":""},{"word":"c"}],"translatedLyric":"t"}]}})",
+        R"({"type":"lyric-change","data":{"yrcData":[{"startTime":100,"words":[{"word":"x","startTime":100}]},)"
+            R"({"startTime":200,"endTime":300,"words":[{"word":"","startTime":200,"endTime":250}]},)"
+            R"({"startTime":400,"endTime":500,"translatedLyric":"only a translation"},)"
+            R"({"endTime":700,"words":[{"word":"y","endTime":650},{"word":"z","startTime":650,"endTime":700}]}]}})",
+        R"({"type":"lyric-change","data":{"transData":[{"startTime":1},{"word":"w"},{"startTime":3,"word":"v"}]}})",
+        // Keys the decoder does not know, nested values and nulls in odd places
+        R"({"type":"lyric-change","extra":{"lrcData":[{"words":[{"word":"no"}]}]},"data":{"lrcData":[{"startTime":1,)"
+            R"("words":[{"word":"ok","meta":{"word":"no","startTime":9}}],"romanLyric":null,"isBG":true}],"yrcData":null}})",
+    };
+    for (const char* message : messages)
+        CHECK(MatchesDom(message));
+}
+
+// "type" after "data" still decodes the lyrics that came before it
+static void TypeAfterData()
+{
+    std::string message = R"({"data":{"lrcData":[{"startTime":1,"words":[{"word":"late"}]}]},"type":"lyric-change"})";
+    CHECK(MatchesDom(message));
+}
+
+// The small messages: the fields the DOM path read with value(...) defaults
+static void OtherMessages()
+{
+    MessageParser::Message status;
+    CHECK(MessageParser::Parse(R"({"type":"status-change","data":{"status":true}})", status));
+    CHECK(status.type == MessageType::StatusChange);
+    CHECK(status.isPlaying);
+
+    MessageParser::Message song;
+    CHECK(MessageParser::Parse(R"({"type":"song-change","data":{"title":"T é","name":"N","artist":"A","album":"Al","duration":215000.0,"cover":{"url":"x"}}})", song));
+    CHECK(song.type == MessageType::SongChange);
+    CHECK(song.song.title == L"T é" && song.song.name == L"N" && song.song.artist == L"A" && song.song.album == L"Al");
+    CHECK_EQ(song.song.duration, 215000);
+
+    MessageParser::Message progress;
+    CHECK(MessageParser::Parse(R"({"type":"progress-change","data":{"currentTime":61234,"duration":215000}})", progress));
+    CHECK(progress.type == MessageType::ProgressChange);
+    CHECK_EQ(progress.progress.currentTime, 61234);
+    CHECK_EQ(progress.progress.duration, 215000);
+
+    MessageParser::Message partial;
+    CHECK(MessageParser::Parse(R"({"data":{"currentTime":5},"type":"progress-change"})", partial));
+    CHECK(partial.type == MessageType::ProgressChange);
+    CHECK_EQ(partial.progress.currentTime, 5);
+    CHECK_EQ(partial.progress.duration, 0);
+
+    MessageParser::Message error;
+    CHECK(MessageParser::Parse(R"({"type":"error","data":{"message":"bad command"}})", error));
+    CHECK(error.type == MessageType::Error && error.error == "bad command");
+    MessageParser::Message bareError;
+    CHECK(MessageParser::Parse(R"({"type":"error","data":{}})", bareError));
+    CHECK(bareError.error == "Unknown error");
+
+    MessageParser::Message welcome;
+    CHECK(MessageParser::Parse(R"({"type":"welcome","data":{"version":"3.0"}})", welcome));
+    CHECK(welcome.type == MessageType::Welcome);
+
+    MessageParser::Message unknown;
+    CHECK(MessageParser::Parse(R"({"type":"something-new","data":{"lrcData":[{"startTime":1,"words":[{"word":"x"}]}]}})", unknown));
+    CHECK(unknown.type == MessageType::Unknown);
+}
+
+static void Malformed()
+{
+    const char* messages[] = { "", "{", "not json", R"({"type":"lyric-change","data":{"lrcData":[{"startTime":1,)" };
+    for (const char* message : messages)
+    {
+        MessageParser::Message msg;
+        CHECK(!MessageParser::Parse(message, msg));
+    }
+}
+
+int main()
+{
+    RUN_TEST(LrcOnly);
+    RUN_TEST(Yrc);
+    RUN_TEST(YrcWithTranslations);
+    RUN_TEST(MissingFields);
+    RUN_TEST(TypeAfterData);
+    RUN_TEST(OtherMessages);
+    RUN_TEST(Malformed);
+    return TestFailures() == 0 ? 0 : 1;
+}
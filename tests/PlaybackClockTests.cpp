@@ -0,0 +1,227 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * PlaybackClock Simulation Tests
+ */
+
+#include "TestCheck.h"
+#include "PlaybackClock.h"
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <random>
+
+namespace
+{
+    // A simulated player reporting its position over a delaying connection.
+    // Time advances in 2 ms steps; samples are delivered in order.
+    struct Simulation
+    {
+        PlaybackClock clock;
+        std::mt19937 rng{ 42 };
+        int minDelayUs = 5000;
+        int maxDelayUs = 60000;
+        int periodMs = 250;
+        double rate = 1.0;
+
+        int64_t nowUs = 1000000;
+        double truthBase = 0.0;
+        int64_t truthAnchorUs = 1000000;
+        int64_t nextSampleUs = 1000000;
+        std::deque<std::pair<int64_t, int64_t>> inFlight;  // position, delivery time
+
+        double lastEstimate = -1e9;
+        int backwardSteps = 0;
+
+        Simulation() { clock.SetPlaying(true, nowUs); }
+
+        double Truth() const { return truthBase + (nowUs - truthAnchorUs) / 1000.0 * rate; }
+        double Estimate() const { return clock.Current().PositionAt(nowUs); }
+
+        void Seek(double delta)
+        {
+            truthBase = Truth() + delta;
+            truthAnchorUs = nowUs;
+            lastEstimate = -1e9;
+        }
+
+        void SetRate(double newRate)
+        {
+            truthBase = Truth();
+            truthAnchorUs = nowUs;
+            rate = newRate;
+        }
+
+        // Runs for the given time; returns the mean and max of estimate - truth
+        void Run(int ms, double* meanError = nullptr, double* maxAbsError = nullptr)
+        {
+            std::uniform_int_distribution<int> delay(minDelayUs, maxDelayUs);
+            double sum = 0.0, maxAbs = 0.0;
+            int count = 0;
+            for (int64_t end = nowUs + ms * 1000LL; nowUs < end; nowUs += 2000)
+            {
+                if (nowUs >= nextSampleUs)
+                {
+                    int64_t deliverUs = nowUs + delay(rng);
+                    if (!inFlight.empty())
+                        deliverUs = (std::max)(deliverUs, inFlight.back().second);
+                    inFlight.push_back({ (int64_t)Truth(), deliverUs });
+                    nextSampleUs += periodMs * 1000LL;
+                }
+                while (!inFlight.empty() && inFlight.front().second <= nowUs)
+                {
+                    clock.AddSample(inFlight.front().first, nowUs);
+                    inFlight.pop_front();
+                }
+
+                double estimate = Estimate();
+                if (estimate < lastEstimate - 1e-6)
+                    ++backwardSteps;
+                lastEstimate = estimate;
+
+                double error = estimate - Truth();
+                sum += error;
+                maxAbs = (std::max)(maxAbs, std::fabs(error));
+                ++count;
+            }
+            if (meanError)
+                *meanError = sum / count;
+            if (maxAbsError)
+                *maxAbsError = maxAbs;
+        }
+    };
+}
+
+// The estimate trails the truth by the mean delivery delay and never steps back
+static void SteadyWithNoisyDelays()
+{
+    Simulation sim;
+    sim.Run(5000);
+    sim.backwardSteps = 0;
+    double mean = 0.0, maxAbs = 0.0;
+    sim.Run(60000, &mean, &maxAbs);
+    std::printf("    mean %.1f ms, max %.1f ms\n", mean, maxAbs);
+    CHECK(mean < -20.0 && mean > -45.0);
+    CHECK(maxAbs < 80.0);
+    CHECK_EQ(sim.backwardSteps, 0);
+}
+
+// A sample delayed well beyond the others is slewed, not applied as a seek
+static void LateSampleIsSlewed()
+{
+    Simulation sim;
+    sim.Run(10000);
+    sim.backwardSteps = 0;
+    sim.minDelayUs = sim.maxDelayUs = 140000;
+    sim.Run(300);
+    sim.minDelayUs = 5000;
+    sim.maxDelayUs = 60000;
+    double maxAbs = 0.0;
+    sim.Run(3000, nullptr, &maxAbs);
+    CHECK(maxAbs < 150.0);
+    CHECK_EQ(sim.backwardSteps, 0);
+}
+
+// A short backward seek takes effect with the first sample that reports it
+static void ShortBackwardSeek()
+{
+    for (double delta : { -200.0, -700.0 })
+    {
+        Simulation sim;
+        sim.Run(20000);
+        sim.Seek(delta);
+        sim.Run(sim.periodMs + 60);
+
+        double mean = 0.0, maxAbs = 0.0;
+        sim.Run(4000, &mean, &maxAbs);
+        std::printf("    seek %.0f ms: then mean %.1f ms, max %.1f ms\n", delta, mean, maxAbs);
+        CHECK(maxAbs < 80.0);
+        CHECK(std::fabs(sim.clock.Current().rate - 1.0) < 0.05);
+    }
+}
+
+// Forward seeks past the threshold jump; those below it are slewed in
+static void ForwardSeek()
+{
+    Simulation sim;
+    sim.Run(10000);
+    sim.Seek(5000.0);
+    sim.Run(sim.periodMs + 60);
+    double maxAbs = 0.0;
+    sim.Run(3000, nullptr, &maxAbs);
+    CHECK(maxAbs < 80.0);
+}
+
+// Playback at other speeds settles without a standing error
+static void OtherPlaybackRates()
+{
+    for (double rate : { 0.75, 1.25, 2.0 })
+    {
+        for (int period : { 250, 1000 })
+        {
+            Simulation sim;
+            sim.rate = rate;
+            sim.periodMs = period;
+            sim.Run(10000);
+            sim.backwardSteps = 0;
+            double mean = 0.0, maxAbs = 0.0;
+            sim.Run(30000, &mean, &maxAbs);
+            std::printf("    %.2fx every %d ms: mean %.1f ms, max %.1f ms\n", rate, period, mean, maxAbs);
+
+            // Only the delivery delay, scaled by the playback rate
+            CHECK(mean < 0.0 && mean > -45.0 * rate);
+            CHECK(std::fabs(sim.clock.Current().rate - rate) < 0.05 * rate);
+            CHECK_EQ(sim.backwardSteps, 0);
+        }
+    }
+}
+
+// A speed change without a seek is followed as well
+static void RateChange()
+{
+    Simulation sim;
+    sim.Run(10000);
+    sim.SetRate(1.5);
+    sim.Run(5000);
+    double mean = 0.0;
+    sim.Run(10000, &mean);
+    CHECK(mean < 0.0 && mean > -70.0);
+    CHECK(std::fabs(sim.clock.Current().rate - 1.5) < 0.05);
+}
+
+// Paused time measures no rate, and the position holds while paused
+static void PauseAndResume()
+{
+    Simulation sim;
+    sim.Run(10000);
+
+    sim.clock.SetPlaying(false, sim.nowUs);
+    double frozen = sim.Estimate();
+    sim.nowUs += 5000000;
+    CHECK_EQ(sim.Estimate(), frozen);
+
+    // The player resumes where it paused
+    sim.truthAnchorUs = sim.nowUs;
+    sim.truthBase = frozen;
+    sim.nextSampleUs = sim.nowUs;
+    sim.lastEstimate = -1e9;
+    sim.clock.SetPlaying(true, sim.nowUs);
+
+    double maxAbs = 0.0;
+    sim.Run(500);
+    sim.Run(5000, nullptr, &maxAbs);
+    CHECK(maxAbs < 80.0);
+    CHECK(std::fabs(sim.clock.Current().rate - 1.0) < 0.05);
+}
+
+int main()
+{
+    RUN_TEST(SteadyWithNoisyDelays);
+    RUN_TEST(LateSampleIsSlewed);
+    RUN_TEST(ShortBackwardSeek);
+    RUN_TEST(ForwardSeek);
+    RUN_TEST(OtherPlaybackRates);
+    RUN_TEST(RateChange);
+    RUN_TEST(PauseAndResume);
+    return TestFailures() == 0 ? 0 : 1;
+}
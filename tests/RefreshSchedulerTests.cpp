@@ -0,0 +1,294 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * RefreshScheduler Tests
+ */
+
+#include "TestCheck.h"
+#include "RefreshScheduler.h"
+#include "LyricTimeline.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    typedef RefreshScheduler::Input Input;
+
+    Input Playing(int64_t time)
+    {
+        Input input;
+        input.yrcPlaying = true;
+        input.time = time;
+        return input;
+    }
+
+    Input ActiveWord(int64_t time, int64_t start, int64_t duration, int width)
+    {
+        Input input = Playing(time);
+        input.hasActiveWord = true;
+        input.wordStart = start;
+        input.wordDuration = duration;
+        input.wordWidth = width;
+        return input;
+    }
+
+    // Highlighted pixel columns of a word, as the renderer computes them
+    int Fill(int64_t time, int64_t start, int64_t duration, int width)
+    {
+        if (time < start)
+            return 0;
+        if (duration <= 0 || time - start >= duration)
+            return width;
+        return (int)((time - start) * width / duration);
+    }
+
+    struct TimedWord
+    {
+        int64_t start;
+        int64_t end;
+        int width;
+    };
+
+    struct TimedLine
+    {
+        int64_t start;
+        std::vector<TimedWord> words;
+    };
+
+    // Plays a timeline from its first line to the end of its last, waking only
+    // when the scheduler asks, the way the refresh timer does
+    struct Playback
+    {
+        LyricTimeline timeline;
+        std::vector<std::vector<int>> widths;
+        int wakeups = 0;
+        int maxInterval = 0;
+        int minInterval = RefreshScheduler::MAX_INTERVAL_MS;
+        int64_t latestWordStart = 0;   // Largest delay between a word starting and a wakeup
+        int largestFillStep = 0;       // Largest highlight change between wakeups, in pixels
+
+        explicit Playback(const std::vector<TimedLine>& lines)
+        {
+            for (const TimedLine& line : lines)
+            {
+                timeline.BeginLine();
+                std::vector<int> lineWidths;
+                for (const TimedWord& word : line.words)
+                {
+                    timeline.BeginWord();
+                    timeline.AppendWordText("w");
+                    timeline.EndWord(word.start, word.end);
+                    lineWidths.push_back(word.width);
+                }
+                timeline.EndLine(line.start, line.words.empty() ? line.start : line.words.back().end);
+                widths.push_back(lineWidths);
+            }
+            timeline.Finish();
+        }
+
+        Input MakeInput(int64_t time) const
+        {
+            Input input = Playing(time);
+            int line = timeline.FindLine(time);
+            if ((size_t)(line + 1) < timeline.LineCount())
+                input.nextLineStart = timeline.LineStart(line + 1);
+            if (line < 0)
+                return input;
+
+            LyricTimeline::LineWords words = timeline.Words(line);
+            size_t active = timeline.CompletedWords(line, time);
+            if (active < words.size())
+            {
+                input.hasActiveWord = true;
+                input.wordStart = words[active].startTime;
+                input.wordDuration = words[active].duration;
+                input.wordWidth = widths[line][active];
+                if (active + 1 < words.size())
+                    input.nextWordStart = words[active + 1].startTime;
+            }
+            return input;
+        }
+
+        void Run(int64_t from, int64_t to)
+        {
+            std::vector<int64_t> starts;
+            for (size_t word = 0; word < timeline.WordCount(); ++word)
+                starts.push_back(timeline.WordStart(word));
+            for (size_t line = 0; line < timeline.LineCount(); ++line)
+                starts.push_back(timeline.LineStart(line));
+
+            int64_t time = from;
+            while (time < to)
+            {
+                Input input = MakeInput(time);
+                int interval = RefreshScheduler::NextInterval(input);
+                ++wakeups;
+                maxInterval = (std::max)(maxInterval, interval);
+                minInterval = (std::min)(minInterval, interval);
+
+                int64_t next = time + interval;
+                for (int64_t start : starts)
+                {
+                    // A start inside this sleep is shown at the wakeup after it
+                    if (start > time && start < next)
+                        latestWordStart = (std::max)(latestWordStart, next - start);
+                }
+                if (input.hasActiveWord && next <= input.wordStart + input.wordDuration)
+                {
+                    int step = Fill(next, input.wordStart, input.wordDuration, input.wordWidth) -
+                        Fill(time, input.wordStart, input.wordDuration, input.wordWidth);
+                    if (interval > RefreshScheduler::MIN_INTERVAL_MS)
+                        largestFillStep = (std::max)(largestFillStep, step);
+                }
+                time = next;
+            }
+        }
+    };
+}
+
+static void ClampsToRange()
+{
+    // A pixel every millisecond would ask for 1 ms
+    CHECK_EQ(RefreshScheduler::NextInterval(ActiveWord(1000, 1000, 100, 400)), RefreshScheduler::MIN_INTERVAL_MS);
+    // Nothing pending at all
+    CHECK_EQ(RefreshScheduler::NextInterval(Playing(1000)), RefreshScheduler::MAX_INTERVAL_MS);
+    // A deadline already passed, e.g. after a late wakeup
+    Input late = Playing(1000);
+    late.nextWordStart = 900;
+    CHECK_EQ(RefreshScheduler::NextInterval(late), RefreshScheduler::MIN_INTERVAL_MS);
+    // A far line start
+    Input far = Playing(1000);
+    far.nextLineStart = 60000;
+    CHECK_EQ(RefreshScheduler::NextInterval(far), RefreshScheduler::MAX_INTERVAL_MS);
+    // An animation step
+    Input animated = Playing(1000);
+    animated.animationMs = 40;
+    CHECK_EQ(RefreshScheduler::NextInterval(animated), 40);
+    animated.animationMs = 0;
+    CHECK_EQ(RefreshScheduler::NextInterval(animated), RefreshScheduler::MIN_INTERVAL_MS);
+}
+
+static void WakesAtWordBoundaries()
+{
+    // Next word and next line starts are deadlines
+    Input input = Playing(1000);
+    input.nextWordStart = 1100;
+    input.nextLineStart = 1200;
+    CHECK_EQ(RefreshScheduler::NextInterval(input), 100);
+    input.nextWordStart = -1;
+    CHECK_EQ(RefreshScheduler::NextInterval(input), 200);
+
+    // A 1000 ms word 50 px wide grows a pixel every 20 ms, 25 px every 40 ms
+    CHECK_EQ(RefreshScheduler::NextInterval(ActiveWord(1000, 1000, 1000, 50)), 20);
+    CHECK_EQ(RefreshScheduler::NextInterval(ActiveWord(1005, 1000, 1000, 25)), 40 - 5);
+    // A held 2 s note 4 px wide moves every 500 ms, capped at the maximum
+    CHECK_EQ(RefreshScheduler::NextInterval(ActiveWord(1000, 1000, 2000, 4)), RefreshScheduler::MAX_INTERVAL_MS);
+    // In the gap before the active word starts, wait for its start
+    CHECK_EQ(RefreshScheduler::NextInterval(ActiveWord(1000, 1100, 500, 50)), 100 + 10);
+    // Not laid out yet: poll
+    CHECK_EQ(RefreshScheduler::NextInterval(ActiveWord(1000, 1000, 500, 0)), RefreshScheduler::MIN_INTERVAL_MS);
+    // A zero-length word completes at its start
+    CHECK_EQ(RefreshScheduler::NextInterval(ActiveWord(1000, 1050, 0, 30)), 50);
+}
+
+// Paused, or not showing YRC at all: a slow poll, whatever else is set
+static void PausedAndNoYrc()
+{
+    Input paused = ActiveWord(1000, 1000, 100, 400);
+    paused.animationMs = 0;
+    paused.nextWordStart = 1001;
+    paused.yrcPlaying = false;
+    CHECK_EQ(RefreshScheduler::NextInterval(paused), RefreshScheduler::MAX_INTERVAL_MS);
+
+    Input none;
+    CHECK_EQ(RefreshScheduler::NextInterval(none), RefreshScheduler::MAX_INTERVAL_MS);
+
+    // Playing YRC between lines, with no word active
+    Input gap = Playing(5000);
+    gap.nextLineStart = 9000;
+    CHECK_EQ(RefreshScheduler::NextInterval(gap), RefreshScheduler::MAX_INTERVAL_MS);
+}
+
+// A whole song: every word start is picked up within one minimum interval,
+// the highlight never jumps more than a pixel between wakeups, and held
+// notes and gaps cost far fewer wakeups than a fixed 16 ms tick
+static void SimulatedTimeline()
+{
+    std::vector<TimedLine> lines = {
+        { 1000, { { 1000, 1300, 40 }, { 1300, 1500, 30 }, { 1500, 1520, 10 }, { 1520, 1520, 20 }, { 1520, 4520, 60 } } },
+        // Overlapping words and a gap inside the line
+        { 8000, { { 8000, 8600, 50 }, { 8200, 8400, 20 }, { 9000, 9400, 80 } } },
+        // A fast run of short, wide words
+        { 10000, { { 10000, 10050, 120 }, { 10050, 10100, 120 }, { 10100, 10150, 120 } } },
+    };
+    Playback playback(lines);
+    playback.Run(0, 12000);
+
+    std::printf("    %d wakeups in 12 s (fixed tick: %d), intervals %d..%d ms\n",
+        playback.wakeups, 12000 / RefreshScheduler::MIN_INTERVAL_MS, playback.minInterval, playback.maxInterval);
+    CHECK(playback.minInterval >= RefreshScheduler::MIN_INTERVAL_MS);
+    CHECK(playback.maxInterval <= RefreshScheduler::MAX_INTERVAL_MS);
+    CHECK(playback.latestWordStart <= RefreshScheduler::MIN_INTERVAL_MS);
+    CHECK(playback.largestFillStep <= 1);
+    CHECK(playback.wakeups < 12000 / RefreshScheduler::MIN_INTERVAL_MS / 3);
+}
+
+// A long instrumental section sleeps at the maximum interval throughout
+static void InstrumentalGap()
+{
+    Playback playback({ { 1000, { { 1000, 1200, 20 } } }, { 61000, { { 61000, 61200, 20 } } } });
+    playback.Run(2000, 60000);
+    CHECK_EQ(playback.minInterval, RefreshScheduler::MAX_INTERVAL_MS);
+    CHECK_EQ(playback.wakeups, (60000 - 2000) / RefreshScheduler::MAX_INTERVAL_MS);
+}
+
+static void WakeupStatsWindow()
+{
+    WakeupStats stats;
+    int completed = 0;
+
+    // 10 wakeups a second, then a burst second of 60
+    for (int64_t t = 0; t < 59000; t += 100)
+        completed += stats.Record(t);
+    for (int64_t t = 59000; t < 60000; t += 1000 / 60)
+        completed += stats.Record(t);
+    CHECK_EQ(completed, 0);
+
+    // The first wakeup of the next second closes the window
+    CHECK(stats.Record(60000));
+    CHECK(stats.Average() > 10.0 && stats.Average() < 11.0);
+    CHECK(stats.P99() >= 60);
+
+    // The next window starts from scratch
+    completed = 0;
+    for (int64_t t = 60250; t < 120000; t += 250)
+        completed += stats.Record(t);
+    CHECK_EQ(completed, 0);
+    CHECK(stats.Record(120000));
+    CHECK(stats.Average() > 3.9 && stats.Average() < 4.1);
+    CHECK_EQ(stats.P99(), 4);
+}
+
+// Asleep longer than a window (e.g. nothing playing): no stale report
+static void WakeupStatsLongSleep()
+{
+    WakeupStats stats;
+    for (int64_t t = 0; t < 30000; t += 100)
+        CHECK(!stats.Record(t));
+    CHECK(!stats.Record(30000 + 5 * 60 * 1000));
+    CHECK(!stats.Record(30000 + 5 * 60 * 1000 + 1000));
+}
+
+int main()
+{
+    RUN_TEST(ClampsToRange);
+    RUN_TEST(WakesAtWordBoundaries);
+    RUN_TEST(PausedAndNoYrc);
+    RUN_TEST(SimulatedTimeline);
+    RUN_TEST(InstrumentalGap);
+    RUN_TEST(WakeupStatsWindow);
+    RUN_TEST(WakeupStatsLongSleep);
+    return TestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * SocketIo Send Benchmark
+ */
+
+#include "LoopbackSocket.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace LoopbackSocket;
+
+// Frames per second through SendAll over loopback, with a reader draining
+// the other end: control-sized frames (the client's usual traffic) and
+// large ones that keep running into a full send buffer
+static void Run(const char* name, size_t payloadSize, int frames)
+{
+    Loopback pair;
+    size_t total = (payloadSize + 6) * (size_t)frames;
+
+    std::thread reader([&pair, total]()
+    {
+        std::vector<char> buffer(64 * 1024);
+        for (size_t drained = 0; drained < total;)
+        {
+            size_t n = 0;
+            SocketIo::Status status = SocketIo::Receive(pair.server, buffer.data(), buffer.size(), n);
+            if (status == SocketIo::Status::Ready)
+                drained += n;
+            else if (status != SocketIo::Status::WouldBlock || SocketIo::WaitReadable(pair.server, 1000) != SocketIo::Status::Ready)
+                return;
+        }
+    });
+
+    char header[6] = { (char)0x81, (char)0x80, 1, 2, 3, 4 };
+    std::string payload(payloadSize, 'x');
+    int sent = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (; sent < frames; ++sent)
+    {
+        SocketIo::SendBuffer buffers[2] = { { header, sizeof(header) }, { payload.data(), payload.size() } };
+        if (SocketIo::SendAll(pair.client, buffers, 2, 2000) != SocketIo::Status::Ready)
+            break;
+    }
+    reader.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-8s %8zu-byte frames: %10.0f sends/s, %8.1f MB/s\n",
+        name, payloadSize, sent / seconds, total / seconds / 1e6);
+}
+
+int main()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    Run("control", 50, 200000);
+    Run("pong", 125, 200000);
+    Run("large", 256 * 1024, 2000);
+    return 0;
+}
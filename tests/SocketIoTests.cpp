@@ -0,0 +1,149 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * SocketIo Loopback Tests
+ */
+
+#include "TestCheck.h"
+#include "LoopbackSocket.h"
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace LoopbackSocket;
+
+static void ReceiveStates()
+{
+    Loopback pair;
+    char buffer[64];
+    size_t received = 99;
+
+    CHECK(SocketIo::Receive(pair.client, buffer, sizeof(buffer), received) == SocketIo::Status::WouldBlock);
+    CHECK_EQ(received, 0u);
+    CHECK(SocketIo::WaitReadable(pair.client, 20) == SocketIo::Status::Timeout);
+
+    CHECK(SendAllBlocking(pair.server, "hello", 5));
+    CHECK(SocketIo::WaitReadable(pair.client, 1000) == SocketIo::Status::Ready);
+    CHECK(SocketIo::Receive(pair.client, buffer, sizeof(buffer), received) == SocketIo::Status::Ready);
+    CHECK_EQ(received, 5u);
+    CHECK(memcmp(buffer, "hello", 5) == 0);
+
+    // Capacity is respected; the rest stays queued
+    CHECK(SendAllBlocking(pair.server, "0123456789", 10));
+    CHECK(SocketIo::WaitReadable(pair.client, 1000) == SocketIo::Status::Ready);
+    CHECK(SocketIo::Receive(pair.client, buffer, 4, received) == SocketIo::Status::Ready);
+    CHECK_EQ(received, 4u);
+    CHECK(SocketIo::WaitReadable(pair.client, 0) == SocketIo::Status::Ready);
+    CHECK(SocketIo::Receive(pair.client, buffer, sizeof(buffer), received) == SocketIo::Status::Ready);
+    CHECK_EQ(received, 6u);
+
+    // A hang-up wakes the wait, and the receive then reports it
+    pair.CloseServer();
+    CHECK(SocketIo::WaitReadable(pair.client, 1000) == SocketIo::Status::Ready);
+    CHECK(SocketIo::Receive(pair.client, buffer, sizeof(buffer), received) == SocketIo::Status::Closed);
+}
+
+// A megabyte through small socket buffers: every send comes back
+// short or would block, and the reader must still see every byte in order
+static void SendAllShortWrites()
+{
+    Loopback pair;
+    int small = 16 * 1024;
+    setsockopt(pair.client, SOL_SOCKET, SO_SNDBUF, (const char*)&small, sizeof(small));
+    setsockopt(pair.server, SOL_SOCKET, SO_RCVBUF, (const char*)&small, sizeof(small));
+
+    std::string header(14, '\0');
+    std::string payload(1024 * 1024, '\0');
+    for (size_t i = 0; i < header.size(); ++i)
+        header[i] = (char)(0xF0 + i);
+    for (size_t i = 0; i < payload.size(); ++i)
+        payload[i] = (char)(i * 31 + i / 4096);
+    std::string expected = header + payload + "tail";
+
+    std::string received;
+    std::thread reader([&pair, &received, &expected]()
+    {
+        char buffer[1500];
+        while (received.size() < expected.size())
+        {
+            size_t n = 0;
+            SocketIo::Status status = SocketIo::Receive(pair.server, buffer, sizeof(buffer), n);
+            if (status == SocketIo::Status::Ready)
+                received.append(buffer, n);
+            else if (status != SocketIo::Status::WouldBlock || SocketIo::WaitReadable(pair.server, 1000) != SocketIo::Status::Ready)
+                return;
+        }
+    });
+
+    SocketIo::SendBuffer buffers[3] = {
+        { header.data(), header.size() },
+        { payload.data(), payload.size() },
+        { "tail", 4 },
+    };
+    CHECK(SocketIo::SendAll(pair.client, buffers, 3, 5000) == SocketIo::Status::Ready);
+    reader.join();
+
+    CHECK_EQ(received.size(), expected.size());
+    CHECK(received == expected);
+    CHECK_EQ(buffers[1].size, 0u);
+}
+
+// Empty buffers are skipped, and a zero-length payload still sends the header
+static void SendAllEmptyBuffers()
+{
+    Loopback pair;
+    SocketIo::SendBuffer buffers[3] = { { "", 0 }, { "ab", 2 }, { "", 0 } };
+    CHECK(SocketIo::SendAll(pair.client, buffers, 3, 1000) == SocketIo::Status::Ready);
+
+    char buffer[8];
+    size_t n = 0;
+    CHECK(SocketIo::WaitReadable(pair.server, 1000) == SocketIo::Status::Ready);
+    CHECK(SocketIo::Receive(pair.server, buffer, sizeof(buffer), n) == SocketIo::Status::Ready);
+    CHECK(n == 2 && memcmp(buffer, "ab", 2) == 0);
+}
+
+// A peer that never reads: the send gives up after the timeout instead of
+// reporting the frame as sent. Small socket buffers fill up quickly.
+static void SendAllTimesOut()
+{
+    Loopback pair;
+    int small = 4 * 1024;
+    setsockopt(pair.client, SOL_SOCKET, SO_SNDBUF, (const char*)&small, sizeof(small));
+    setsockopt(pair.server, SOL_SOCKET, SO_RCVBUF, (const char*)&small, sizeof(small));
+
+    std::string payload(1024 * 1024, 'x');
+    SocketIo::SendBuffer buffer = { payload.data(), payload.size() };
+    CHECK(SocketIo::SendAll(pair.client, &buffer, 1, 100) == SocketIo::Status::Timeout);
+    CHECK(buffer.size > 0 && buffer.size < payload.size());
+}
+
+// Sending to a closed peer fails rather than hanging or raising SIGPIPE
+static void SendAllToClosedPeer()
+{
+    Loopback pair;
+    pair.CloseServer();
+    std::string payload(1024 * 1024, 'x');
+
+    SocketIo::Status status = SocketIo::Status::Ready;
+    for (int i = 0; i < 64 && status == SocketIo::Status::Ready; ++i)
+    {
+        SocketIo::SendBuffer buffer = { payload.data(), payload.size() };
+        status = SocketIo::SendAll(pair.client, &buffer, 1, 1000);
+    }
+    CHECK(status == SocketIo::Status::Failed);
+}
+
+int main()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    RUN_TEST(ReceiveStates);
+    RUN_TEST(SendAllShortWrites);
+    RUN_TEST(SendAllEmptyBuffers);
+    RUN_TEST(SendAllTimesOut);
+    RUN_TEST(SendAllToClosedPeer);
+    return TestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Minimal Test Assertions
+ */
+
+#pragma once
+
+#include <cstdio>
+
+// Failed checks so far; a test program returns it from main()
+inline int& TestFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond) \
+    do { if (!(cond)) { ++TestFailures(); std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } } while (0)
+
+#define CHECK_EQ(a, b) \
+    do { if (!((a) == (b))) { ++TestFailures(); std::printf("%s:%d: CHECK_EQ(%s, %s) failed\n", __FILE__, __LINE__, #a, #b); } } while (0)
+
+// Run one test function and report it
+#define RUN_TEST(fn) \
+    do { int before = TestFailures(); fn(); std::printf("%s %s\n", TestFailures() == before ? "[ OK ]" : "[FAIL]", #fn); } while (0)
@@ -0,0 +1,292 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * TextEncoding Tests
+ */
+
+#include "TestCheck.h"
+#include "TextEncoding.h"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Reference decoder written straight from the Unicode well-formed byte
+    // sequence table (Table 3-7), replacing each maximal subpart of an
+    // ill-formed sequence with one U+FFFD
+    std::u32string ReferenceDecode(const std::string& input)
+    {
+        std::u32string out;
+        const unsigned char* s = reinterpret_cast<const unsigned char*>(input.data());
+        size_t n = input.size();
+        size_t i = 0;
+        while (i < n)
+        {
+            unsigned char b = s[i];
+            size_t need;
+            unsigned char lo = 0x80, hi = 0xBF;
+            char32_t cp;
+            if (b < 0x80) { out.push_back(b); ++i; continue; }
+            else if (b >= 0xC2 && b <= 0xDF) { need = 1; cp = b & 0x1F; }
+            else if (b == 0xE0) { need = 2; lo = 0xA0; cp = b & 0x0F; }
+            else if ((b >= 0xE1 && b <= 0xEC) || b == 0xEE || b == 0xEF) { need = 2; cp = b & 0x0F; }
+            else if (b == 0xED) { need = 2; hi = 0x9F; cp = b & 0x0F; }
+            else if (b == 0xF0) { need = 3; lo = 0x90; cp = b & 0x07; }
+            else if (b >= 0xF1 && b <= 0xF3) { need = 3; cp = b & 0x07; }
+            else if (b == 0xF4) { need = 3; hi = 0x8F; cp = b & 0x07; }
+            else { out.push_back(0xFFFD); ++i; continue; }
+
+            size_t k = 1;
+            for (; k <= need && i + k < n; ++k)
+            {
+                unsigned char c = s[i + k];
+                unsigned char l = k == 1 ? lo : 0x80;
+                unsigned char h = k == 1 ? hi : 0xBF;
+                if (c < l || c > h)
+                    break;
+                cp = (cp << 6) | (c & 0x3F);
+            }
+            if (k > need)
+                out.push_back(cp);
+            else
+                out.push_back(0xFFFD);
+            i += k;
+        }
+        return out;
+    }
+
+    std::u16string ToUtf16(const std::u32string& codePoints)
+    {
+        std::u16string out;
+        for (char32_t cp : codePoints)
+        {
+            if (cp >= 0x10000)
+            {
+                out.push_back((char16_t)(0xD800 + ((cp - 0x10000) >> 10)));
+                out.push_back((char16_t)(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+            }
+            else
+            {
+                out.push_back((char16_t)cp);
+            }
+        }
+        return out;
+    }
+
+    // wchar_t is UTF-16 on Windows and UTF-32 elsewhere
+    std::wstring ToWide(const std::u32string& codePoints)
+    {
+        std::wstring out;
+        if (sizeof(wchar_t) == 2)
+        {
+            for (char16_t unit : ToUtf16(codePoints))
+                out.push_back((wchar_t)unit);
+        }
+        else
+        {
+            for (char32_t cp : codePoints)
+                out.push_back((wchar_t)cp);
+        }
+        return out;
+    }
+
+    bool Matches(const std::string& input)
+    {
+        std::u32string expected = ReferenceDecode(input);
+
+        std::u16string utf16;
+        size_t appended16 = DecodeUtf8Append(utf16, input);
+        std::wstring wide;
+        size_t appendedWide = DecodeUtf8Append(wide, input);
+
+        return utf16 == ToUtf16(expected) && appended16 == utf16.size() &&
+            wide == ToWide(expected) && appendedWide == wide.size();
+    }
+
+    std::u16string Decode16(const std::string& input)
+    {
+        std::u16string out;
+        DecodeUtf8Append(out, input);
+        return out;
+    }
+}
+
+static void WellFormed()
+{
+    CHECK(Decode16("") == u"");
+    CHECK(Decode16("Hello") == u"Hello");
+    CHECK(Decode16("\xC3\xA9t\xC3\xA9") == u"été");
+    CHECK(Decode16("\xE6\xAD\x8C\xE8\xAF\x8D") == u"歌词");
+    CHECK(Decode16("\xEF\xBF\xBD") == u"�");
+    CHECK(Matches("Mixed \xE6\xAD\x8C lyric \xC3\xA9 line"));
+}
+
+// Code points above U+FFFF become surrogate pairs in UTF-16
+static void SupplementaryPlanes()
+{
+    CHECK(Decode16("\xF0\x90\x80\x80") == u"\U00010000");
+    CHECK(Decode16("\xF0\x9F\x8E\xB5") == u"\U0001F3B5");
+    CHECK(Decode16("\xF4\x8F\xBF\xBF") == u"\U0010FFFF");
+    CHECK(Decode16("a\xF0\x9F\x8E\xB5" "b") == u"a\U0001F3B5b");
+
+    std::u16string pair = Decode16("\xF0\x9F\x8E\xB5");
+    CHECK_EQ(pair.size(), 2u);
+    CHECK(pair.size() == 2 && pair[0] == 0xD83C && pair[1] == 0xDFB5);
+
+    std::wstring wide;
+    DecodeUtf8Append(wide, "\xF0\x9F\x8E\xB5");
+    CHECK_EQ(wide.size(), sizeof(wchar_t) == 2 ? 2u : 1u);
+}
+
+// One U+FFFD per maximal subpart, as in the Unicode standard's own examples
+static void MalformedSequences()
+{
+    // Unicode 3.9, "U+FFFD Substitution of Maximal Subparts"
+    CHECK(Decode16("\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64") ==
+        u"a���b�c��d");
+
+    // Overlong forms: every byte is its own subpart
+    CHECK(Decode16("\xC0\xAF") == u"��");
+    CHECK(Decode16("\xE0\x80\xAF") == u"���");
+    CHECK(Decode16("\xF0\x80\x80\xAF") == u"����");
+
+    // Encoded surrogates
+    CHECK(Decode16("\xED\xA0\x80") == u"���");
+    CHECK(Decode16("\xED\xBF\xBF") == u"���");
+    CHECK(Decode16("\xED\x9F\xBF") == u"퟿");
+
+    // Above U+10FFFF and invalid lead bytes
+    CHECK(Decode16("\xF4\x90\x80\x80") == u"����");
+    CHECK(Decode16("\xF5\x80") == u"��");
+    CHECK(Decode16("\xFF") == u"�");
+
+    // Truncated sequences: the valid prefix is one subpart
+    CHECK(Decode16("\xE6\xAD") == u"�");
+    CHECK(Decode16("\xF0\x9F\x8E") == u"�");
+    CHECK(Decode16("\xF0\x9F\x8E" "a") == u"�a");
+    CHECK(Decode16("\xE6\xAD\xE6\xAD\x8C") == u"�歌");
+    CHECK(Decode16("\xC3") == u"�");
+}
+
+// Every one- and two-byte input, and all three-byte inputs over the bytes
+// where the decoding rules change
+static void ExhaustiveShortInputs()
+{
+    int failures = 0;
+    for (int a = 0; a < 256; ++a)
+    {
+        for (int b = 0; b < 256; ++b)
+        {
+            if (!Matches(std::string{ (char)a, (char)b }))
+                ++failures;
+        }
+    }
+
+    const unsigned char edges[] = { 0x00, 0x41, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC1, 0xC2,
+        0xDF, 0xE0, 0xE1, 0xEC, 0xED, 0xEE, 0xEF, 0xF0, 0xF1, 0xF3, 0xF4, 0xF5, 0xFF };
+    for (unsigned char a : edges)
+        for (unsigned char b : edges)
+            for (unsigned char c : edges)
+                for (unsigned char d : edges)
+                {
+                    if (!Matches(std::string{ (char)a, (char)b, (char)c, (char)d }))
+                        ++failures;
+                    if (!Matches(std::string{ (char)a, (char)b, (char)c }))
+                        ++failures;
+                }
+
+    CHECK_EQ(failures, 0);
+}
+
+// ASCII runs of every length up to well past two vector widths, followed by
+// a multi-byte or invalid sequence, starting at every source alignment. This
+// crosses the 16-byte SSE2 loop, the 8-byte loop and the byte tail.
+static void AsciiFastPathBoundaries()
+{
+    const std::string tails[] = { "", "\xC3\xA9", "\xE6\xAD\x8C", "\xF0\x9F\x8E\xB5", "\x80", "\xE6\xAD" };
+    int failures = 0;
+    for (size_t prefix = 0; prefix < 4; ++prefix)
+    {
+        for (size_t run = 0; run <= 48; ++run)
+        {
+            for (const std::string& tail : tails)
+            {
+                std::string buffer(prefix, 'p');
+                for (size_t i = 0; i < run; ++i)
+                    buffer.push_back((char)(0x20 + (i * 13) % 0x5F));
+                buffer += tail;
+                buffer += "after";
+
+                std::string_view input(buffer);
+                input.remove_prefix(prefix);
+                if (!Matches(std::string(input)))
+                    ++failures;
+
+                // Decoding from an offset into the caller's buffer, too
+                std::u16string direct;
+                DecodeUtf8Append(direct, input);
+                if (direct != ToUtf16(ReferenceDecode(std::string(input))))
+                    ++failures;
+            }
+        }
+    }
+    CHECK_EQ(failures, 0);
+
+    // A high byte at each position of a 16-byte block stops the vector loop there
+    for (size_t pos = 0; pos < 32; ++pos)
+    {
+        std::string input(40, 'a');
+        input[pos] = (char)0xA9;
+        CHECK(Matches(input));
+    }
+}
+
+// Appending keeps what is already in the string
+static void AppendsToExisting()
+{
+    std::u16string out = u"ab";
+    CHECK_EQ(DecodeUtf8Append(out, "\xE6\xAD\x8C" "cd"), 3u);
+    CHECK(out == u"ab歌cd");
+
+    std::wstring wide = L"x";
+    DecodeUtf8Append(wide, "yz");
+    CHECK(wide == L"xyz");
+    CHECK(DecodeUtf8("lyric") == L"lyric");
+}
+
+static void RandomizedInputs()
+{
+    std::mt19937 rng(99);
+    const char* pieces[] = { "a", "lyric ", "\xC3\xA9", "\xE6\xAD\x8C", "\xF0\x9F\x8E\xB5", "\x80", "\xC0",
+        "\xED\xA0", "\xF4\x90", "\xE0\x80", "0123456789abcdef" };
+    int failures = 0;
+    for (int round = 0; round < 20000; ++round)
+    {
+        std::string input;
+        int count = rng() % 24;
+        for (int i = 0; i < count; ++i)
+        {
+            if (rng() % 4 == 0)
+                input.push_back((char)(rng() & 0xFF));
+            else
+                input += pieces[rng() % (sizeof(pieces) / sizeof(pieces[0]))];
+        }
+        if (!Matches(input))
+            ++failures;
+    }
+    CHECK_EQ(failures, 0);
+}
+
+int main()
+{
+    RUN_TEST(WellFormed);
+    RUN_TEST(SupplementaryPlanes);
+    RUN_TEST(MalformedSequences);
+    RUN_TEST(ExhaustiveShortInputs);
+    RUN_TEST(AsciiFastPathBoundaries);
+    RUN_TEST(AppendsToExisting);
+    RUN_TEST(RandomizedInputs);
+    return TestFailures() == 0 ? 0 : 1;
+}
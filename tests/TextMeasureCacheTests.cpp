@@ -0,0 +1,65 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * TextMeasureCache Tests
+ */
+
+#include "TestCheck.h"
+#include "FakeTextMeasurer.h"
+#include "TextMeasureCache.h"
+#include <string>
+
+static void TextCacheHitsAndMisses()
+{
+    FakeTextMeasurer measurer;
+    TextMeasureCache cache;
+
+    TextExtent first = cache.Measure(measurer, L"Song - Artist");
+    CHECK_EQ(first.cx, 130);
+    CHECK_EQ(first.cy, 20);
+    TextExtent again = cache.Measure(measurer, L"Song - Artist");
+    CHECK_EQ(again.cx, 130);
+    CHECK_EQ(measurer.calls.size(), 1u);
+    CHECK_EQ(cache.Stats().hits, 1u);
+    CHECK_EQ(cache.Stats().misses, 1u);
+
+    // Same text in another font is another entry
+    measurer.SetFont(12, 24);
+    CHECK_EQ(cache.Measure(measurer, L"Song - Artist").cx, 156);
+    CHECK_EQ(measurer.calls.size(), 2u);
+
+    // Switching back still hits the first one
+    measurer.SetFont(10, 20);
+    CHECK_EQ(cache.Measure(measurer, L"Song - Artist").cx, 130);
+    CHECK_EQ(measurer.calls.size(), 2u);
+
+    cache.Clear();
+    cache.Measure(measurer, L"Song - Artist");
+    CHECK_EQ(measurer.calls.size(), 3u);
+}
+
+// A fixed table replaced round-robin: the oldest entry goes first
+static void TextCacheEviction()
+{
+    FakeTextMeasurer measurer;
+    TextMeasureCache cache;
+
+    for (size_t i = 0; i < TextMeasureCache::CAPACITY; ++i)
+        cache.Measure(measurer, std::to_wstring(i));
+    for (size_t i = 0; i < TextMeasureCache::CAPACITY; ++i)
+        cache.Measure(measurer, std::to_wstring(i));
+    CHECK_EQ(measurer.calls.size(), TextMeasureCache::CAPACITY);
+
+    cache.Measure(measurer, L"one more");
+    cache.Measure(measurer, std::to_wstring(1));
+    CHECK_EQ(measurer.calls.size(), TextMeasureCache::CAPACITY + 1);
+    cache.Measure(measurer, std::to_wstring(0));
+    CHECK_EQ(measurer.calls.size(), TextMeasureCache::CAPACITY + 2);
+}
+
+int main()
+{
+    RUN_TEST(TextCacheHitsAndMisses);
+    RUN_TEST(TextCacheEviction);
+    return TestFailures() == 0 ? 0 : 1;
+}
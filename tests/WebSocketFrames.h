@@ -0,0 +1,46 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * WebSocket Frame Builder for Tests
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace WebSocketFrames
+{
+    // One frame as a server would send it; masked only to exercise the unmask path
+    inline std::string MakeFrame(int opcode, bool fin, const std::string& payload, bool masked = false, uint32_t key = 0)
+    {
+        std::string frame;
+        frame.push_back((char)((fin ? 0x80 : 0) | opcode));
+
+        unsigned char maskBit = masked ? 0x80 : 0;
+        uint64_t len = payload.size();
+        if (len < 126)
+        {
+            frame.push_back((char)(maskBit | len));
+        }
+        else if (len <= 0xFFFF)
+        {
+            frame.push_back((char)(maskBit | 126));
+            frame.push_back((char)(len >> 8));
+            frame.push_back((char)len);
+        }
+        else
+        {
+            frame.push_back((char)(maskBit | 127));
+            for (int i = 7; i >= 0; --i)
+                frame.push_back((char)(len >> (i * 8)));
+        }
+
+        unsigned char keyBytes[4] = { (unsigned char)(key >> 24), (unsigned char)(key >> 16), (unsigned char)(key >> 8), (unsigned char)key };
+        if (masked)
+            frame.append((const char*)keyBytes, 4);
+        for (size_t i = 0; i < payload.size(); ++i)
+            frame.push_back(masked ? (char)(payload[i] ^ keyBytes[i % 4]) : payload[i]);
+        return frame;
+    }
+}
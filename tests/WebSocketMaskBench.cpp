@@ -0,0 +1,84 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * WebSocket Masking Benchmark
+ */
+
+#include "WebSocketMask.h"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// The byte-at-a-time loop the client used before the shared kernel
+static void ByteMask(unsigned char* dst, const unsigned char* src, size_t len, const unsigned char key[4])
+{
+    for (size_t i = 0; i < len; ++i)
+        dst[i] = src[i] ^ key[i % 4];
+}
+
+// MB/s masking payloads of one size in place, with the data starting one
+// byte past an aligned address like a payload behind a frame header
+template <typename Mask>
+static double Measure(Mask mask, size_t size)
+{
+    const unsigned char key[4] = { 0x37, 0xFA, 0x21, 0x3D };
+    std::vector<unsigned char> buffer(size + 64, 0x5A);
+    unsigned char* data = buffer.data() + 1;
+
+    size_t rounds = (size_t)(256 * 1024 * 1024) / (size + 16) + 1;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rounds; ++i)
+        mask(data, data, size, key);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Keep the result observable so the loop is not dropped
+    volatile unsigned char sink = data[size / 2];
+    (void)sink;
+    return (double)size * rounds / seconds / 1e6;
+}
+
+int main()
+{
+    const size_t sizes[] = { 16, 125, 1024, 16 * 1024, 256 * 1024, 2 * 1024 * 1024 };
+    struct
+    {
+        WebSocketMaskKernel kernel;
+        const char* name;
+    } kernels[] = {
+        { WebSocketMaskKernel::Word, "word" },
+        { WebSocketMaskKernel::Sse2, "sse2" },
+        { WebSocketMaskKernel::Avx2, "avx2" },
+        { WebSocketMaskKernel::Neon, "neon" },
+    };
+
+    std::printf("%-10s", "MB/s");
+    for (size_t size : sizes)
+        std::printf("%12zu", size);
+    std::printf("\n");
+
+    std::printf("%-10s", "byte");
+    for (size_t size : sizes)
+        std::printf("%12.0f", Measure(ByteMask, size));
+    std::printf("\n");
+
+    for (const auto& k : kernels)
+    {
+        if (!WebSocketMaskKernelAvailable(k.kernel))
+            continue;
+        std::printf("%-10s", k.name);
+        for (size_t size : sizes)
+        {
+            std::printf("%12.0f", Measure([&k](unsigned char* dst, const unsigned char* src, size_t len, const unsigned char key[4])
+            {
+                ApplyWebSocketMaskWith(k.kernel, dst, src, len, key);
+            }, size));
+        }
+        std::printf("\n");
+    }
+
+    std::printf("%-10s", "dispatch");
+    for (size_t size : sizes)
+        std::printf("%12.0f", Measure(ApplyWebSocketMask, size));
+    std::printf("\n");
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * WebSocket Masking Kernel Tests
+ */
+
+#include "TestCheck.h"
+#include "WebSocketMask.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const size_t MAX_OFFSET = 64;
+    const size_t MAX_LENGTH = 4096;
+    const size_t GUARD = 64;
+    const unsigned char CANARY = 0xA5;
+
+    struct Kernel
+    {
+        WebSocketMaskKernel kernel;
+        const char* name;
+    };
+
+    const Kernel KERNELS[] = {
+        { WebSocketMaskKernel::Word, "word" },
+        { WebSocketMaskKernel::Sse2, "sse2" },
+        { WebSocketMaskKernel::Avx2, "avx2" },
+        { WebSocketMaskKernel::Neon, "neon" },
+    };
+
+    // The byte-at-a-time masking the client used to do, as the reference
+    void ReferenceMask(unsigned char* dst, const unsigned char* src, size_t len, const unsigned char key[4])
+    {
+        for (size_t i = 0; i < len; ++i)
+            dst[i] = src[i] ^ key[i % 4];
+    }
+
+    std::vector<unsigned char> Pattern(size_t size)
+    {
+        std::vector<unsigned char> data(size);
+        for (size_t i = 0; i < size; ++i)
+            data[i] = (unsigned char)(i * 131 + (i >> 8) * 7 + 1);
+        return data;
+    }
+
+    bool AllCanary(const unsigned char* p, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (p[i] != CANARY)
+                return false;
+        }
+        return true;
+    }
+
+    // Every source and destination offset 0..63 against every length
+    // 0..4096. The bytes around the destination must stay untouched.
+    bool CheckOutOfPlace(const Kernel& kernel, const unsigned char key[4])
+    {
+        std::vector<unsigned char> plain = Pattern(MAX_LENGTH);
+        std::vector<unsigned char> expected(MAX_LENGTH);
+        ReferenceMask(expected.data(), plain.data(), MAX_LENGTH, key);
+
+        std::vector<unsigned char> srcBuffer(MAX_OFFSET + MAX_LENGTH);
+        std::vector<unsigned char> dstBuffer(MAX_OFFSET + MAX_LENGTH + GUARD);
+        for (size_t srcOffset = 0; srcOffset < MAX_OFFSET; ++srcOffset)
+        {
+            unsigned char* src = srcBuffer.data() + srcOffset;
+            memcpy(src, plain.data(), MAX_LENGTH);
+            for (size_t dstOffset = 0; dstOffset < MAX_OFFSET; ++dstOffset)
+            {
+                unsigned char* dst = dstBuffer.data() + dstOffset;
+                memset(dstBuffer.data(), CANARY, dstBuffer.size());
+                for (size_t len = 0; len <= MAX_LENGTH; ++len)
+                {
+                    ApplyWebSocketMaskWith(kernel.kernel, dst, src, len, key);
+                    if (memcmp(dst, expected.data(), len) != 0 || !AllCanary(dst + len, GUARD) ||
+                        !AllCanary(dstBuffer.data(), dstOffset) || memcmp(src, plain.data(), MAX_LENGTH) != 0)
+                    {
+                        std::printf("    %s: mismatch at src offset %zu, dst offset %zu, length %zu\n", kernel.name, srcOffset, dstOffset, len);
+                        return false;
+                    }
+                    // Put the canary back so the next length proves it wrote every byte
+                    memset(dst, CANARY, len);
+                }
+            }
+        }
+        return true;
+    }
+
+    // In place, the way received frames are unmasked, at every offset and length
+    bool CheckInPlace(const Kernel& kernel, const unsigned char key[4])
+    {
+        std::vector<unsigned char> plain = Pattern(MAX_LENGTH);
+        std::vector<unsigned char> expected(MAX_LENGTH);
+        ReferenceMask(expected.data(), plain.data(), MAX_LENGTH, key);
+
+        std::vector<unsigned char> buffer(MAX_OFFSET + MAX_LENGTH + GUARD);
+        for (size_t offset = 0; offset < MAX_OFFSET; ++offset)
+        {
+            unsigned char* data = buffer.data() + offset;
+            memset(buffer.data(), CANARY, buffer.size());
+            for (size_t len = 0; len <= MAX_LENGTH; ++len)
+            {
+                memcpy(data, plain.data(), len);
+                ApplyWebSocketMaskWith(kernel.kernel, data, data, len, key);
+                if (memcmp(data, expected.data(), len) != 0 || !AllCanary(data + len, GUARD) || !AllCanary(buffer.data(), offset))
+                {
+                    std::printf("    %s: in-place mismatch at offset %zu, length %zu\n", kernel.name, offset, len);
+                    return false;
+                }
+                memset(data, CANARY, len);
+            }
+        }
+        return true;
+    }
+}
+
+static void KernelsMatchReference()
+{
+    const unsigned char key[4] = { 0x37, 0xFA, 0x21, 0x3D };
+    int tested = 0;
+    for (const Kernel& kernel : KERNELS)
+    {
+        if (!WebSocketMaskKernelAvailable(kernel.kernel))
+        {
+            std::printf("    %s: not available here, skipped\n", kernel.name);
+            continue;
+        }
+        CHECK(CheckOutOfPlace(kernel, key));
+        CHECK(CheckInPlace(kernel, key));
+        ++tested;
+    }
+    CHECK(WebSocketMaskKernelAvailable(WebSocketMaskKernel::Word));
+    CHECK(tested >= 1);
+}
+
+// The dispatching entry point, over the same offsets and lengths in place,
+// and with keys whose bytes are all distinct so any phase slip shows
+static void DispatchMatchesReference()
+{
+    const unsigned char keys[][4] = { { 0x37, 0xFA, 0x21, 0x3D }, { 0x00, 0x00, 0x00, 0x00 }, { 0xFF, 0x01, 0x80, 0x7F } };
+    std::vector<unsigned char> plain = Pattern(MAX_LENGTH);
+    std::vector<unsigned char> expected(MAX_LENGTH);
+    std::vector<unsigned char> buffer(MAX_OFFSET + MAX_LENGTH + GUARD);
+
+    for (const auto& key : keys)
+    {
+        ReferenceMask(expected.data(), plain.data(), MAX_LENGTH, key);
+        bool ok = true;
+        for (size_t offset = 0; offset < MAX_OFFSET && ok; ++offset)
+        {
+            unsigned char* data = buffer.data() + offset;
+            memset(buffer.data(), CANARY, buffer.size());
+            for (size_t len = 0; len <= MAX_LENGTH && ok; ++len)
+            {
+                memcpy(data, plain.data(), len);
+                ApplyWebSocketMask(data, data, len, key);
+                ok = memcmp(data, expected.data(), len) == 0 && AllCanary(data + len, GUARD) && AllCanary(buffer.data(), offset);
+                memset(data, CANARY, len);
+            }
+        }
+        CHECK(ok);
+    }
+}
+
+// Masking twice with the same key gives the original back
+static void RoundTrip()
+{
+    const unsigned char key[4] = { 0x12, 0x34, 0x56, 0x78 };
+    std::vector<unsigned char> plain = Pattern(100000);
+    std::vector<unsigned char> data = plain;
+    ApplyWebSocketMask(data.data(), data.data(), data.size(), key);
+    CHECK(data != plain);
+    ApplyWebSocketMask(data.data(), data.data(), data.size(), key);
+    CHECK(data == plain);
+}
+
+int main()
+{
+    RUN_TEST(KernelsMatchReference);
+    RUN_TEST(DispatchMatchesReference);
+    RUN_TEST(RoundTrip);
+    return TestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * Frame Arrival to Callback Latency Benchmark
+ */
+
+#include "LoopbackSocket.h"
+#include "WebSocketFrames.h"
+#include "WebSocketReader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace LoopbackSocket;
+using WebSocketFrames::MakeFrame;
+
+static int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// A server thread writes one text frame at a time, stamped with the time it
+// was handed to the socket; the reader's handler takes the difference when
+// the message reaches it. The next frame goes out only after the previous
+// one arrived, so no frame waits behind another.
+static void Run(const char* name, size_t payloadSize, int frames)
+{
+    Loopback pair;
+    std::atomic<bool> running{ true };
+    WebSocketReader reader(running);
+    reader.Reset(pair.client, 16 * 1024 * 1024);
+
+    std::vector<double> latencyUs;
+    latencyUs.reserve(frames);
+    std::atomic<int> handled{ 0 };
+
+    std::thread client([&]()
+    {
+        reader.Run([&](FrameDecoder::Event event, std::string_view data)
+        {
+            if (event != FrameDecoder::Event::Text || data.size() < sizeof(int64_t))
+                return;
+            int64_t sent;
+            memcpy(&sent, data.data(), sizeof(sent));
+            latencyUs.push_back((NowNs() - sent) / 1000.0);
+            handled.fetch_add(1, std::memory_order_release);
+        });
+    });
+
+    std::string frame = MakeFrame(0x1, true, std::string(payloadSize, 'x'));
+    size_t stampOffset = frame.size() - payloadSize;
+    for (int i = 0; i < frames; ++i)
+    {
+        int64_t now = NowNs();
+        memcpy(&frame[stampOffset], &now, sizeof(now));
+        SendAllBlocking(pair.server, frame.data(), frame.size());
+        while (handled.load(std::memory_order_acquire) <= i)
+            std::this_thread::yield();
+    }
+
+    std::string close = MakeFrame(0x8, true, "");
+    SendAllBlocking(pair.server, close.data(), close.size());
+    client.join();
+
+    std::sort(latencyUs.begin(), latencyUs.end());
+    auto at = [&latencyUs](double q) { return latencyUs[(size_t)(q * (latencyUs.size() - 1))]; };
+    std::printf("%-9s %8zu-byte frames: median %7.1f us, p90 %7.1f us, p99 %7.1f us, max %8.1f us (%zu frames)\n",
+        name, payloadSize, at(0.5), at(0.9), at(0.99), latencyUs.back(), latencyUs.size());
+}
+
+int main()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    Run("progress", 80, 5000);
+    Run("song", 600, 2000);
+    Run("lyrics", 256 * 1024, 200);
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * SPlayerLyric - SPlayer Lyric Display Plugin for TrafficMonitor
+ *
+ * WebSocketReader Loopback Tests
+ */
+
+#include "TestCheck.h"
+#include "LoopbackSocket.h"
+#include "WebSocketFrames.h"
+#include "WebSocketReader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace LoopbackSocket;
+using WebSocketFrames::MakeFrame;
+
+namespace
+{
+    struct Received
+    {
+        FrameDecoder::Event event;
+        std::string data;
+    };
+
+    // The client side of a loopback connection with its reader running on
+    // a thread of its own, like the client's worker
+    struct ReaderThread
+    {
+        Loopback pair;
+        std::atomic<bool> running{ true };
+        WebSocketReader reader{ running };
+        std::mutex mutex;
+        std::vector<Received> frames;
+        WebSocketReader::End end = WebSocketReader::End::Stopped;
+        std::thread thread;
+
+        explicit ReaderThread(bool handshake = false)
+        {
+            reader.Reset(pair.client, 1024 * 1024);
+            thread = std::thread([this, handshake]()
+            {
+                std::string response;
+                if (handshake && !reader.ReadHandshakeResponse(response))
+                    return;
+                if (handshake)
+                    Record(FrameDecoder::Event::NeedMore, response);
+                end = reader.Run([this](FrameDecoder::Event event, std::string_view data)
+                {
+                    Record(event, std::string(data));
+                });
+            });
+        }
+
+        ~ReaderThread()
+        {
+            Join();
+        }
+
+        void Record(FrameDecoder::Event event, const std::string& data)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            frames.push_back({ event, data });
+        }
+
+        void Join()
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+    };
+}
+
+// The upgrade response and the first frames arrive in one segment: the
+// frames stay buffered and are dispatched once Run() starts
+static void HandshakeThenFrames()
+{
+    ReaderThread client(true);
+    std::string stream = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n\r\n";
+    stream += MakeFrame(0x1, true, "{\"type\":\"welcome\"}");
+    stream += MakeFrame(0x8, true, "");
+    CHECK(SendAllBlocking(client.pair.server, stream.data(), stream.size()));
+    client.Join();
+
+    CHECK(client.end == WebSocketReader::End::CloseFrame);
+    CHECK_EQ(client.frames.size(), 2u);
+    if (client.frames.size() == 2)
+    {
+        CHECK(client.frames[0].data == "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n\r\n");
+        CHECK(client.frames[1].event == FrameDecoder::Event::Text);
+        CHECK(client.frames[1].data == "{\"type\":\"welcome\"}");
+    }
+}
+
+// Frames trickle in a few bytes at a time, with a fragmented message and a
+// ping in the middle of it: every message reaches the handler whole and in order
+static void FramesAcrossSegments()
+{
+    ReaderThread client;
+    std::string stream;
+    stream += MakeFrame(0x1, true, "first");
+    stream += MakeFrame(0x1, false, "frag");
+    stream += MakeFrame(0x9, true, "ping");
+    stream += MakeFrame(0x0, false, "ment");
+    stream += MakeFrame(0x0, true, "ed");
+    stream += MakeFrame(0x1, true, std::string(70000, 'y'));
+    stream += MakeFrame(0x8, true, "");
+
+    for (size_t pos = 0; pos < stream.size();)
+    {
+        size_t n = (std::min)(stream.size() - pos, pos < 64 ? (size_t)3 : (size_t)4096);
+        CHECK(SendAllBlocking(client.pair.server, stream.data() + pos, n));
+        pos += n;
+        std::this_thread::yield();
+    }
+    client.Join();
+
+    CHECK(client.end == WebSocketReader::End::CloseFrame);
+    CHECK_EQ(client.frames.size(), 4u);
+    if (client.frames.size() == 4)
+    {
+        CHECK(client.frames[0].event == FrameDecoder::Event::Text && client.frames[0].data == "first");
+        CHECK(client.frames[1].event == FrameDecoder::Event::Ping && client.frames[1].data == "ping");
+        CHECK(client.frames[2].event == FrameDecoder::Event::Text && client.frames[2].data == "fragmented");
+        CHECK(client.frames[3].event == FrameDecoder::Event::Text && client.frames[3].data == std::string(70000, 'y'));
+    }
+}
+
+// The server going away ends the loop instead of leaving it waiting
+static void PeerCloses()
+{
+    ReaderThread client;
+    std::string frame = MakeFrame(0x1, true, "last");
+    CHECK(SendAllBlocking(client.pair.server, frame.data(), frame.size()));
+    client.pair.CloseServer();
+    client.Join();
+
+    CHECK(client.end == WebSocketReader::End::Disconnected);
+    CHECK_EQ(client.frames.size(), 1u);
+}
+
+// A frame the decoder rejects ends the loop with a protocol error
+static void ProtocolError()
+{
+    ReaderThread client;
+    std::string frame = MakeFrame(0x0, true, "orphan continuation");
+    CHECK(SendAllBlocking(client.pair.server, frame.data(), frame.size()));
+    client.Join();
+
+    CHECK(client.end == WebSocketReader::End::ProtocolError);
+    CHECK(client.frames.empty());
+}
+
+// Clearing running stops an idle reader at its next poll timeout
+static void StopWhileIdle()
+{
+    ReaderThread client;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    client.running = false;
+    client.Join();
+
+    CHECK(client.end == WebSocketReader::End::Stopped);
+    CHECK(client.frames.empty());
+}
+
+int main()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    RUN_TEST(HandshakeThenFrames);
+    RUN_TEST(FramesAcrossSegments);
+    RUN_TEST(PeerCloses);
+    RUN_TEST(ProtocolError);
+    RUN_TEST(StopWhileIdle);
+    return TestFailures() == 0 ? 0 : 1;
+}